@@ -1,35 +1,232 @@
 #include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <numeric>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <vector>
 
-std::vector<int> get_input(const std::string& filename) {
+const auto DigitPadding = 8;
+
+struct top_k {
+    std::size_t k;
+    std::vector<int> heap;      // min heap holding the k largest totals seen so far
+
+    explicit top_k(std::size_t k) : k{k} {
+        heap.reserve(k);
+    }
+
+    void push(int value) {
+        if (heap.size() < k) {
+            heap.push_back(value);
+            std::ranges::push_heap(heap, std::greater<>{});
+        } else if (k > 0 && value > heap.front()) {
+            std::ranges::pop_heap(heap, std::greater<>{});
+            heap.back() = value;
+            std::ranges::push_heap(heap, std::greater<>{});
+        }
+    }
+
+    [[nodiscard]] int sum(std::size_t count) const {
+        auto sorted = heap;
+        count = std::min(count, sorted.size());
+        std::ranges::partial_sort(sorted, sorted.begin() + static_cast<std::ptrdiff_t>(count), std::greater<>{});
+        return std::accumulate(sorted.begin(), sorted.begin() + static_cast<std::ptrdiff_t>(count), 0);
+    }
+};
+
+// the whole of text must be a number
+std::optional<int> parse_number(std::string_view text) {
+    int value{0};
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc{} || end != text.data() + text.size())
+        return std::nullopt;
+    return value;
+}
+
+std::optional<top_k> get_input(const std::string& filename, std::size_t k) {
     std::ifstream input{filename};
     std::string line;
-    std::vector<int> result;
+    top_k result{k};
     int current{0};
+    auto inGroup{false};
 
     while (std::getline(input, line)) {
         if (line.empty()) {
-            result.push_back(current);
+            result.push(current);
+            current = 0;
+            inGroup = false;
+        } else {
+            auto value = parse_number(line);
+            if (!value)
+                return std::nullopt;
+            current += *value;
+            inGroup = true;
+        }
+    }
+    if (inGroup)
+        result.push(current);
+    return result;
+}
+
+// parses up to 8 ascii digits at once, p must have at least 8 readable bytes
+std::optional<int> parse_digits(const char* p, std::size_t len) {
+    if (len > DigitPadding)
+        return parse_number({p, len});
+
+    std::uint64_t val;
+    std::memcpy(&val, p, sizeof val);
+    if (len < DigitPadding) {
+        // right align digits, leading bytes become '0'
+        auto shift = (DigitPadding - len) * 8;
+        val = (val << shift) | (0x3030303030303030 >> (64 - shift));
+    }
+
+    // a byte outside '0' to '9' sets its top bit in one of these terms
+    if ((val | (val + 0x4646464646464646) | (val - 0x3030303030303030)) & 0x8080808080808080)
+        return std::nullopt;
+
+    val &= 0x0F0F0F0F0F0F0F0F;
+    val = (val * 10 + (val >> 8)) & 0x00FF00FF00FF00FF;
+    val = (val * 100 + (val >> 16)) & 0x0000FFFF0000FFFF;
+    val = (val * 10000 + (val >> 32)) & 0x00000000FFFFFFFF;
+    return static_cast<int>(val);
+}
+
+struct chunk_result {
+    int head{0};                // lines before the first blank line, belongs to the previous chunk's group
+    int tail{0};                // lines after the last blank line, continues into the next chunk
+    bool has_break{false};
+    bool tail_open{false};
+    bool malformed{false};      // a line was not a number, the rest of the chunk was skipped
+    top_k groups;
+};
+
+chunk_result parse_chunk(std::string_view chunk, std::size_t k) {
+    chunk_result result{.groups = top_k{k}};
+    int current{0};
+    auto open{false};
+
+    for (std::size_t pos{0}; pos < chunk.size();) {
+        auto eol = chunk.find('\n', pos);
+        if (eol == std::string_view::npos)
+            eol = chunk.size();
+
+        if (eol == pos) {
+            if (result.has_break)
+                result.groups.push(current);
+            else
+                result.head = current;
+            result.has_break = true;
             current = 0;
+            open = false;
         } else {
-            current += std::stoi(line);
+            auto value = parse_digits(chunk.data() + pos, eol - pos);
+            if (!value) {
+                result.malformed = true;
+                return result;
+            }
+            current += *value;
+            open = true;
         }
+        pos = eol + 1;
     }
+
+    if (result.has_break)
+        result.tail = current;
+    else
+        result.head = current;
+    result.tail_open = open;
     return result;
 }
 
-int main() {
-    auto input = get_input("input.txt");
-    std::ranges::sort(input);
+std::optional<top_k> get_input_parallel(const std::string& filename, std::size_t k, std::size_t threads) {
+    // one bulk read, workers start straight on the buffer
+    std::ifstream input{filename, std::ios::binary | std::ios::ate};
+    auto size = input ? static_cast<std::size_t>(input.tellg()) : 0;
+    std::string buffer(size + DigitPadding, '\n');
+    input.seekg(0);
+    input.read(buffer.data(), static_cast<std::streamsize>(size));
+    std::string_view data{buffer.data(), size};
+
+    // chunk boundaries always start a line so no number is split
+    std::vector<std::size_t> bounds{0};
+    for (std::size_t i{1}; i < threads; i++) {
+        auto pos = std::max(size * i / threads, bounds.back());
+        auto eol = data.find('\n', pos);
+        bounds.push_back(eol == std::string_view::npos ? size : eol + 1);
+    }
+    bounds.push_back(size);
+
+    std::vector<chunk_result> chunks(threads, chunk_result{.groups = top_k{0}});
+    {
+        std::vector<std::jthread> workers;
+        for (std::size_t i{0}; i < threads; i++) {
+            workers.emplace_back([&, i] {
+                chunks[i] = parse_chunk(data.substr(bounds[i], bounds[i + 1] - bounds[i]), k);
+            });
+        }
+    }
+
+    // stitch groups that span chunk boundaries
+    top_k result{k};
+    int carry{0};
+    auto open{false};
+    for (const auto& chunk : chunks) {
+        if (chunk.malformed)
+            return std::nullopt;
+        if (!chunk.has_break) {
+            carry += chunk.head;
+            open = open || chunk.tail_open;
+            continue;
+        }
+
+        result.push(carry + chunk.head);
+        for (auto total : chunk.groups.heap)
+            result.push(total);
+        carry = chunk.tail;
+        open = chunk.tail_open;
+    }
+    if (open)
+        result.push(carry);
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t k{3};
+    auto parallel{false};
+    for (int i{1}; i < argc; i++) {
+        std::string arg{argv[i]};
+        if (arg == "--parallel")
+            parallel = true;
+        else
+            k = std::stoul(arg);
+    }
+
+    auto heapSize = std::max<std::size_t>(k, 3);
+    auto threads = std::max(1u, std::thread::hardware_concurrency());
+    auto totals = parallel ? get_input_parallel("input.txt", heapSize, threads) : get_input("input.txt", heapSize);
+    if (!totals) {
+        std::cerr << "input.txt: every line must be a number or blank\n";
+        return 1;
+    }
+
+    const auto& input = *totals;
 
     // part 1
-    std::cout << input[input.size() - 1] << '\n';
+    std::cout << input.sum(1) << '\n';
 
     // part 2
-    auto size = input.size();
-    std::cout << (input[size - 1] + input[size - 2] + input[size - 3]) << '\n';
+    std::cout << input.sum(3) << '\n';
+
+    if (k != 3)
+        std::cout << input.sum(k) << '\n';
     return 0;
 }
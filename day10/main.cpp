@@ -1,102 +1,349 @@
 #include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
+#include <optional>
+#include <random>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
 const auto CrtMaxLen = 40;
+const auto CrtHeight = 6;
+const std::uint64_t SpriteMask = 0b111;
+const std::size_t RegisterCount = 4;        // registers w, x, y and z
+const std::size_t RegX = 1;
 
-enum class instruction_type {
+using registers = std::array<int, RegisterCount>;
+
+enum class opcode : std::uint8_t {
+    nop,
     add,
-    nop
+    count
 };
 
 struct instruction {
-    instruction_type type;
+    opcode op;
+    std::uint8_t reg;
     int value;
 
-    instruction(instruction_type type, int value)
-        : type{type}, value{value} {}
+    instruction(opcode op, std::uint8_t reg, int value)
+        : op{op}, reg{reg}, value{value} {}
+};
+
+// an instruction takes its cycles first, then applies its effect at the end of the last cycle
+struct op_info {
+    std::string_view mnemonic;
+    std::size_t cycles;
+    bool has_operand;
+    void (*exec)(registers&, const instruction&);
 };
 
-struct cpu {
-    int reg_val{1};
-    std::size_t current_cycle{0};
-    std::size_t sig_strength{0};
-    std::string crt;
-
-    void execute(const instruction& inst) {
-        current_cycle++;
-        calc_sig_strength();
-        if (inst.type == instruction_type::add) {
-            current_cycle++;
-            calc_sig_strength();
-            reg_val += inst.value;
+constexpr std::array<op_info, static_cast<std::size_t>(opcode::count)> OpTable{{
+    {"noop", 1, false, [](registers&, const instruction&) {}},
+    {"add", 2, true, [](registers& regs, const instruction& inst) { regs[inst.reg] += inst.value; }},
+}};
+
+registers initial_registers() {
+    registers regs{};
+    regs[RegX] = 1;
+    return regs;
+}
+
+// runs the program once, every observer sees the registers during each cycle, returns the number of cycles
+template <typename... Observers>
+std::size_t execute(std::span<const instruction> program, registers& regs, Observers&... observers) {
+    std::size_t cycle{0};
+    for (const auto& inst : program) {
+        const auto& info = OpTable[static_cast<std::size_t>(inst.op)];
+        for (std::size_t i{0}; i < info.cycles; i++) {
+            cycle++;
+            (observers.on_cycle(cycle, regs), ...);
         }
+        info.exec(regs, inst);
     }
+    return cycle;
+}
 
-    [[nodiscard]] bool crt_in_range() const {
-        auto currCrtIdx = (current_cycle - 1) % CrtMaxLen;
-        return currCrtIdx >= reg_val - 1 && currCrtIdx <= reg_val + 1;
+// sums cycle * x over a sorted list of sample cycles
+struct signal_sampler {
+    std::span<const std::size_t> cycles;
+    std::size_t next{0};
+    long long strength{0};
+
+    void on_cycle(std::size_t cycle, const registers& regs) {
+        while (next < cycles.size() && cycles[next] == cycle)
+            strength += static_cast<long long>(cycles[next++]) * regs[RegX];
     }
+};
 
-    void print_crt() {
-        if (crt.size() == CrtMaxLen) {
-            std::cout << crt << '\n';
-            crt.clear();
+// x during every cycle of a program, during[c - 1] is the value during cycle c
+struct reg_timeline {
+    std::vector<int> during;
+    int final_val{1};
+
+    explicit reg_timeline(std::span<const instruction> program) {
+        during.reserve(program.size() * 2);
+        auto regs = initial_registers();
+        execute(program, regs, *this);
+        final_val = regs[RegX];
+    }
+
+    void on_cycle(std::size_t, const registers& regs) {
+        during.push_back(regs[RegX]);
+    }
+
+    // cycles start at 1, cycle 0 reads the initial value
+    [[nodiscard]] int at(std::size_t cycle) const {
+        if (cycle == 0)
+            return during.empty() ? final_val : during.front();
+        return cycle <= during.size() ? during[cycle - 1] : final_val;
+    }
+
+    [[nodiscard]] long long sig_strength(std::span<const std::size_t> cycles) const {
+        long long result{0};
+        for (auto cycle : cycles)
+            result += static_cast<long long>(cycle) * at(cycle);
+        return result;
+    }
+};
+
+// pixels stored as bits, each row padded to whole words
+struct framebuffer {
+    std::size_t width;
+    std::size_t height;
+    std::size_t row_words;
+    std::vector<std::uint64_t> bits;
+
+    framebuffer(std::size_t width, std::size_t height)
+        : width{width}, height{height}, row_words{(width + 63) / 64}, bits(row_words * height) {}
+
+    // bit 0 of the sprite mask sits at reg - 1, a pixel is lit when the mask shifted there covers it
+    [[nodiscard]] static bool sprite_lit(int reg, std::size_t x) {
+        auto shift = static_cast<std::int64_t>(x) - reg + 1;
+        return shift >= 0 && shift < 64 && ((SpriteMask >> shift) & 1);
+    }
+
+    void draw(std::size_t pixel, int reg) {
+        auto x = pixel % width;
+        auto y = pixel / width;
+        bits[y * row_words + x / 64] |= static_cast<std::uint64_t>(sprite_lit(reg, x)) << (x % 64);
+    }
+
+    void clear() {
+        std::ranges::fill(bits, 0);
+    }
+
+    void render(std::string& out) const {
+        for (std::size_t y{0}; y < height; y++) {
+            for (std::size_t x{0}; x < width; x++)
+                out += (bits[y * row_words + x / 64] >> (x % 64)) & 1 ? '#' : '.';
+            out += '\n';
         }
     }
+};
+
+// draws one pixel per cycle, calls onFrame after each completed frame and from finish for a trailing partial frame
+template <typename Func>
+struct crt_screen {
+    framebuffer frame;
+    Func on_frame;
+    std::size_t pixel{0};
 
-    void execute_with_crt(const instruction& inst) {
-        current_cycle++;
-        crt += crt_in_range() ? "#" : ".";
-        print_crt();
+    crt_screen(std::size_t width, std::size_t height, Func onFrame)
+        : frame{width, height}, on_frame{std::move(onFrame)} {}
 
-        if (inst.type == instruction_type::add) {
-            current_cycle++;
-            crt += crt_in_range() ? '#' : '.';
-            reg_val += inst.value;
-            print_crt();
+    void on_cycle(std::size_t, const registers& regs) {
+        frame.draw(pixel, regs[RegX]);
+        if (++pixel == frame.width * frame.height) {
+            on_frame(frame);
+            frame.clear();
+            pixel = 0;
         }
     }
 
-    void calc_sig_strength() {
-        int calc_cyc[] = {20, 60, 100, 140, 180, 220};
-        auto size = (sizeof calc_cyc) / (sizeof *calc_cyc);
-        if (std::binary_search(calc_cyc, calc_cyc + size, current_cycle))
-            sig_strength += reg_val * current_cycle;
+    void finish() {
+        if (pixel != 0)
+            on_frame(frame);
     }
 };
 
-std::vector<instruction> get_input(const std::string& filename) {
+// usage: day10 --crt [width] [height] [frames file], without a file only the last frame is printed
+int run_framebuffer(std::span<const instruction> program, int argc, char* argv[]) {
+    auto width = argc > 2 ? std::stoul(argv[2]) : static_cast<std::size_t>(CrtMaxLen);
+    auto height = argc > 3 ? std::stoul(argv[3]) : static_cast<std::size_t>(CrtHeight);
+    if (width == 0 || height == 0) {
+        std::cerr << "crt width and height must be at least 1\n";
+        return 1;
+    }
+
+    std::string out;
+    out.reserve(height * (width + 1));
+    auto regs = initial_registers();
+
+    if (argc > 4) {
+        std::ofstream file{argv[4], std::ios::binary};
+        crt_screen screen{width, height, [&](const framebuffer& fb) {
+            out.clear();
+            fb.render(out);
+            out += '\n';
+            file.write(out.data(), static_cast<std::streamsize>(out.size()));
+        }};
+        execute(program, regs, screen);
+        screen.finish();
+        return file ? 0 : 1;
+    }
+
+    crt_screen screen{width, height, [&](const framebuffer& fb) {
+        out.clear();
+        fb.render(out);
+    }};
+    execute(program, regs, screen);
+    screen.finish();
+    std::cout.write(out.data(), static_cast<std::streamsize>(out.size()));
+    return 0;
+}
+
+// decodes "<mnemonic>[register] [value]", e.g. "noop" or "addx 3", the register defaults to x
+std::optional<instruction> decode(std::string_view line) {
+    auto space = std::min(line.find(' '), line.size());
+    auto mnemonic = line.substr(0, space);
+    auto operand = line.substr(std::min(space + 1, line.size()));
+
+    for (std::size_t op{0}; op < OpTable.size(); op++) {
+        const auto& info = OpTable[op];
+        if (!mnemonic.starts_with(info.mnemonic))
+            continue;
+
+        auto suffix = mnemonic.substr(info.mnemonic.size());
+        if (suffix.size() > 1 || (suffix.size() == 1 && (suffix[0] < 'w' || suffix[0] > 'z')))
+            continue;
+        if (info.has_operand != (space < line.size()))
+            return std::nullopt;
+
+        auto value{0};
+        if (info.has_operand) {
+            auto [end, ec] = std::from_chars(operand.data(), operand.data() + operand.size(), value);
+            if (ec != std::errc{} || end != operand.data() + operand.size())
+                return std::nullopt;
+        }
+
+        auto reg = suffix.empty() ? RegX : static_cast<std::size_t>(suffix[0] - 'w');
+        return instruction{static_cast<opcode>(op), static_cast<std::uint8_t>(reg), value};
+    }
+    return std::nullopt;
+}
+
+// the whole program or nothing, a line that does not decode is reported instead of skipped
+std::optional<std::vector<instruction>> get_input(const std::string& filename) {
     std::ifstream input{filename};
     std::string line;
     std::vector<instruction> result;
-    while (std::getline(input, line)) {
-        auto space = line.find(' ');
-        if (space != std::string::npos) {
-            auto value = std::stoi(line.substr(space));
-            result.emplace_back(instruction_type::add, value);
-        } else {
-            result.emplace_back(instruction_type::nop, 0);
+    for (std::size_t lineNo{1}; std::getline(input, line); lineNo++) {
+        if (line.empty())
+            continue;
+
+        auto inst = decode(line);
+        if (!inst) {
+            std::cerr << filename << ':' << lineNo << ": cannot decode \"" << line << "\"\n";
+            return std::nullopt;
         }
+        result.push_back(*inst);
     }
 
     return result;
 }
 
-int main() {
-    auto input = get_input("input.txt");
+struct null_observer {
+    void on_cycle(std::size_t, const registers&) {}
+};
+
+template <typename Func>
+double time_ms(Func&& func) {
+    auto start = std::chrono::steady_clock::now();
+    func();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// usage: day10 --bench [instructions], runs a random program bare and with both puzzle observers attached
+void run_benchmark(std::size_t size) {
+    std::mt19937 rng{2022};
+    std::vector<instruction> program;
+    program.reserve(size);
+    for (std::size_t i{0}; i < size; i++) {
+        if (rng() % 3 == 0)
+            program.emplace_back(opcode::nop, static_cast<std::uint8_t>(RegX), 0);
+        else
+            program.emplace_back(opcode::add, static_cast<std::uint8_t>(RegX), static_cast<int>(rng() % 7) - 3);
+    }
+
+    std::vector<std::size_t> samples;
+    for (std::size_t cycle{20}; cycle < size; cycle += 40)
+        samples.push_back(cycle);
+
+    std::cout << "observers       cycles      ms    Minstr/s   Mcycles/s\n";
+    auto report = [size](const char* name, std::size_t cycles, double ms) {
+        std::printf("%-11s %10zu %7.2f %11.2f %11.2f\n", name, cycles, ms, size / ms / 1e3, cycles / ms / 1e3);
+    };
+
+    std::size_t cycles{0};
+    auto ms = time_ms([&] {
+        auto regs = initial_registers();
+        null_observer none;
+        cycles = execute(program, regs, none);
+    });
+    report("none", cycles, ms);
+
+    std::size_t frames{0};
+    ms = time_ms([&] {
+        auto regs = initial_registers();
+        signal_sampler sampler{samples};
+        crt_screen screen{CrtMaxLen, CrtHeight, [&frames](const framebuffer&) { frames++; }};
+        cycles = execute(program, regs, sampler, screen);
+        screen.finish();
+    });
+    report("signal+crt", cycles, ms);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string_view{argv[1]} == "--bench") {
+        run_benchmark(argc > 2 ? std::stoul(argv[2]) : 10'000'000);
+        return 0;
+    }
+
+    auto program = get_input("input.txt");
+    if (!program)
+        return 1;
+
+    const auto& input = *program;
+    if (argc > 1 && std::string_view{argv[1]} == "--crt")
+        return run_framebuffer(input, argc, argv);
+    if (argc > 1) {
+        std::vector<std::size_t> cycles;
+        for (int i{1}; i < argc; i++)
+            cycles.push_back(std::stoul(argv[i]));
+        std::cout << reg_timeline{input}.sig_strength(cycles) << '\n';
+        return 0;
+    }
+
+    // both parts observe one run of the program
+    const std::size_t sampleCycles[] = {20, 60, 100, 140, 180, 220};
+    signal_sampler sampler{sampleCycles};
+    std::string screenOut;
+    crt_screen screen{CrtMaxLen, CrtHeight, [&screenOut](const framebuffer& fb) { fb.render(screenOut); }};
+    auto regs = initial_registers();
+    execute(input, regs, sampler, screen);
+    screen.finish();
 
     // part 1
-    cpu run;
-    std::ranges::for_each(input, [&run](auto&& item){ run.execute(item); });
-    std::cout << run.sig_strength << '\n';
+    std::cout << sampler.strength << '\n';
 
     // part 2
-    run = cpu{};
-    std::ranges::for_each(input, [&run](auto&& item){
-        run.execute_with_crt(item);
-    });
+    std::cout.write(screenOut.data(), static_cast<std::streamsize>(screenOut.size()));
     return 0;
 }
@@ -1,8 +1,23 @@
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
+#include <span>
+#include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
 const auto LoseScore = 0;
 const auto DrawScore = 3;
 const auto WinScore = 6;
@@ -10,83 +25,44 @@ const auto RockScore = 1;
 const auto PaperScore = 2;
 const auto ScissorsScore = 3;
 
-enum class Outcome {
-    Win = 0,
-    Draw = 1,
-    Lose = 2
+// scores indexed by [opponent - 'A'][player - 'X']
+constexpr std::array<int, 9> Part1Scores{
+    RockScore + DrawScore, PaperScore + WinScore, ScissorsScore + LoseScore,
+    RockScore + LoseScore, PaperScore + DrawScore, ScissorsScore + WinScore,
+    RockScore + WinScore, PaperScore + LoseScore, ScissorsScore + DrawScore
 };
 
-bool is_rock(char c) {
-    return c == 'A' || c == 'X';
-}
-
-bool is_paper(char c) {
-    return c == 'B' || c == 'Y';
-}
-
-bool is_scissors(char c) {
-    return c == 'C' || c == 'Z';
-}
-
-bool is_lose(char c) {
-    return c == 'X';
-}
+// scores indexed by [opponent - 'A'][outcome - 'X']
+constexpr std::array<int, 9> Part2Scores{
+    ScissorsScore + LoseScore, RockScore + DrawScore, PaperScore + WinScore,
+    RockScore + LoseScore, PaperScore + DrawScore, ScissorsScore + WinScore,
+    PaperScore + LoseScore, ScissorsScore + DrawScore, RockScore + WinScore
+};
 
-bool is_draw(char c) {
-    return c == 'Y';
+constexpr std::size_t score_idx(char opponent, char player) {
+    return static_cast<std::size_t>(opponent - 'A') * 3 + static_cast<std::size_t>(player - 'X');
 }
 
-bool is_win(char c) {
-    return c == 'Z';
+constexpr int part1_get_score(char opponent, char player) {
+    return Part1Scores[score_idx(opponent, player)];
 }
 
-int part1_get_score(char player, Outcome outcome) {
-    auto addScore = outcome == Outcome::Win ? WinScore : (outcome == Outcome::Draw ? DrawScore : LoseScore);
-    if (is_rock(player))
-        return RockScore + addScore;
-    if (is_paper(player))
-        return PaperScore + addScore;
-    return ScissorsScore + addScore;
+constexpr int part2_get_score(char opponent, char outcome) {
+    return Part2Scores[score_idx(opponent, outcome)];
 }
 
-int part1_get_score(char opponent, char player) {
-    if (is_rock(opponent) && is_rock(player))
-        return part1_get_score(player, Outcome::Draw);
-    if (is_rock(opponent) && is_paper(player))
-        return part1_get_score(player, Outcome::Win);
-    if (is_rock(opponent) && is_scissors(player))
-        return part1_get_score(player, Outcome::Lose);
-    if (is_paper(opponent) && is_rock(player))
-        return part1_get_score(player, Outcome::Lose);
-    if (is_paper(opponent) && is_paper(player))
-        return part1_get_score(player, Outcome::Draw);
-    if (is_paper(opponent) && is_scissors(player))
-        return part1_get_score(player, Outcome::Win);
-    if (is_scissors(opponent) && is_rock(player))
-        return part1_get_score(player, Outcome::Win);
-    if (is_scissors(opponent) && is_paper(player))
-        return part1_get_score(player, Outcome::Lose);
-    return part1_get_score(player, Outcome::Draw);
-}
+static_assert(part1_get_score('A', 'Y') == 8 && part1_get_score('B', 'X') == 1 && part1_get_score('C', 'Z') == 6);
+static_assert(part2_get_score('A', 'Y') == 4 && part2_get_score('B', 'X') == 1 && part2_get_score('C', 'Z') == 7);
 
-int part2_get_score(char opponent, char outcome) {
-    if (is_rock(opponent) && is_win(outcome))
-        return PaperScore + WinScore;
-    if (is_rock(opponent) && is_draw(outcome))
-        return RockScore + DrawScore;
-    if (is_rock(opponent) && is_lose(outcome))
-        return ScissorsScore + LoseScore;
-    if (is_paper(opponent) && is_win(outcome))
-        return ScissorsScore + WinScore;
-    if (is_paper(opponent) && is_draw(outcome))
-        return PaperScore + DrawScore;
-    if (is_paper(opponent) && is_lose(outcome))
-        return RockScore + LoseScore;
-    if (is_scissors(opponent) && is_win(outcome))
-        return RockScore + WinScore;
-    if (is_scissors(opponent) && is_draw(outcome))
-        return ScissorsScore + DrawScore;
-    return PaperScore + LoseScore;
+std::pair<int, int> score_all(std::span<const std::pair<char, char>> games) {
+    int part1{0};
+    int part2{0};
+    for (const auto& game : games) {
+        auto idx = score_idx(game.first, game.second);
+        part1 += Part1Scores[idx];
+        part2 += Part2Scores[idx];
+    }
+    return {part1, part2};
 }
 
 std::vector<std::pair<char, char>> get_input(const std::string& filename) {
@@ -101,21 +77,115 @@ std::vector<std::pair<char, char>> get_input(const std::string& filename) {
     return result;
 }
 
-int main() {
+struct mapped_file {
+    int fd{-1};
+    void* addr{MAP_FAILED};
+    std::size_t size{0};
+
+    explicit mapped_file(const std::string& filename) {
+        fd = ::open(filename.c_str(), O_RDONLY);
+        struct stat st{};
+        if (fd < 0 || ::fstat(fd, &st) != 0 || st.st_size == 0)
+            return;
+
+        size = static_cast<std::size_t>(st.st_size);
+        addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED)
+            ::madvise(addr, size, MADV_SEQUENTIAL);
+    }
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    ~mapped_file() {
+        if (addr != MAP_FAILED)
+            ::munmap(addr, size);
+        if (fd >= 0)
+            ::close(fd);
+    }
+
+    [[nodiscard]] std::string_view data() const {
+        if (addr == MAP_FAILED)
+            return {};
+        return {static_cast<const char*>(addr), size};
+    }
+};
+
+// scores packed "A X\n" records straight from memory, the last record may omit its newline
+std::pair<std::uint64_t, std::uint64_t> score_records(std::string_view data) {
+    std::uint64_t part1{0};
+    std::uint64_t part2{0};
+    std::size_t pos{0};
+
+#if defined(__SSSE3__)
+    // 16 records per iteration, gather opponent and player bytes into one lane each
+    const auto table1 = _mm_setr_epi8(
+        Part1Scores[0], Part1Scores[1], Part1Scores[2], Part1Scores[3], Part1Scores[4], Part1Scores[5],
+        Part1Scores[6], Part1Scores[7], Part1Scores[8], 0, 0, 0, 0, 0, 0, 0);
+    const auto table2 = _mm_setr_epi8(
+        Part2Scores[0], Part2Scores[1], Part2Scores[2], Part2Scores[3], Part2Scores[4], Part2Scores[5],
+        Part2Scores[6], Part2Scores[7], Part2Scores[8], 0, 0, 0, 0, 0, 0, 0);
+    const __m128i opponentMasks[]{
+        _mm_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1),
+        _mm_setr_epi8(-1, -1, -1, -1, 0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1),
+        _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, 0, 4, 8, 12, -1, -1, -1, -1),
+        _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 4, 8, 12)
+    };
+    const __m128i playerMasks[]{
+        _mm_setr_epi8(2, 6, 10, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1),
+        _mm_setr_epi8(-1, -1, -1, -1, 2, 6, 10, 14, -1, -1, -1, -1, -1, -1, -1, -1),
+        _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, 2, 6, 10, 14, -1, -1, -1, -1),
+        _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 6, 10, 14)
+    };
+    const auto baseOpponent = _mm_set1_epi8('A');
+    const auto basePlayer = _mm_set1_epi8('X');
+    const auto zero = _mm_setzero_si128();
+    auto acc1 = _mm_setzero_si128();
+    auto acc2 = _mm_setzero_si128();
+
+    for (; pos + 64 <= data.size(); pos += 64) {
+        auto opponent = _mm_setzero_si128();
+        auto player = _mm_setzero_si128();
+        for (std::size_t i{0}; i < 4; i++) {
+            auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data.data() + pos + i * 16));
+            opponent = _mm_or_si128(opponent, _mm_shuffle_epi8(block, opponentMasks[i]));
+            player = _mm_or_si128(player, _mm_shuffle_epi8(block, playerMasks[i]));
+        }
+
+        opponent = _mm_sub_epi8(opponent, baseOpponent);
+        player = _mm_sub_epi8(player, basePlayer);
+        auto idx = _mm_add_epi8(_mm_add_epi8(opponent, opponent), _mm_add_epi8(opponent, player));
+        acc1 = _mm_add_epi64(acc1, _mm_sad_epu8(_mm_shuffle_epi8(table1, idx), zero));
+        acc2 = _mm_add_epi64(acc2, _mm_sad_epu8(_mm_shuffle_epi8(table2, idx), zero));
+    }
+
+    part1 += static_cast<std::uint64_t>(_mm_cvtsi128_si64(acc1) + _mm_cvtsi128_si64(_mm_unpackhi_epi64(acc1, acc1)));
+    part2 += static_cast<std::uint64_t>(_mm_cvtsi128_si64(acc2) + _mm_cvtsi128_si64(_mm_unpackhi_epi64(acc2, acc2)));
+#endif
+
+    for (; pos + 3 <= data.size(); pos += 4) {
+        auto idx = score_idx(data[pos], data[pos + 2]);
+        part1 += Part1Scores[idx];
+        part2 += Part2Scores[idx];
+    }
+    return {part1, part2};
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string_view{argv[1]} == "--mapped") {
+        mapped_file file{"input.txt"};
+        auto [part1, part2] = score_records(file.data());
+        std::cout << part1 << '\n' << part2 << '\n';
+        return 0;
+    }
+
     auto input = get_input("input.txt");
-    int score{0};
+    auto [part1, part2] = score_all(input);
 
     // part 1
-    for (const auto& game : input)
-        score += part1_get_score(game.first, game.second);
-
-    std::cout << score << '\n';
+    std::cout << part1 << '\n';
 
     // part 2
-    score = 0;
-    for (const auto& game : input)
-        score += part2_get_score(game.first, game.second);
-
-    std::cout << score << '\n';
+    std::cout << part2 << '\n';
     return 0;
 }
@@ -1,57 +1,365 @@
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <random>
+#include <span>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define HAS_AVX2_KERNEL 1
+#include <immintrin.h>
+#endif
+
+const auto BlockPadding = 32;
+
 int get_priority(char c) {
     return (c >= 'a' && c <= 'z') ? c - 96 : c - 38;
 }
 
-char get_common_char(const std::string& first, const std::string& second) {
-    for (const auto& c : first) {
-        if (second.find(c) != std::string::npos)
+char get_common_char(std::span<const std::string> group) {
+    for (const auto& c : group[0]) {
+        auto inAll = std::all_of(group.begin() + 1, group.end(), [c](auto&& str) { return str.find(c) != std::string::npos; });
+        if (inAll)
             return c;
     }
     return 0;
 }
 
-char get_common_char(const std::string& first, const std::string& second, const std::string& third) {
-    for (const auto& c : first) {
-        if (second.find(c) != std::string::npos && third.find(c) != std::string::npos)
-            return c;
+// bit n is set for letter 'A' + n, upper case land in bits 0 to 25 and lower case in bits 32 to 57
+std::uint64_t get_letter_mask(std::string_view items) {
+    std::uint64_t mask{0};
+    for (auto c : items)
+        mask |= std::uint64_t{1} << ((c - 'A') & 63);
+    return mask;
+}
+
+// moves letter bits to priority bits, a to z become 1 to 26 and A to Z become 27 to 52
+std::uint64_t to_priority_mask(std::uint64_t letters) {
+    const std::uint64_t alphabet{(std::uint64_t{1} << 26) - 1};
+    return ((letters >> 32 & alphabet) << 1) | ((letters & alphabet) << 27);
+}
+
+// bit n is set when an item with priority n is present
+std::uint64_t get_item_mask(std::string_view items) {
+    return to_priority_mask(get_letter_mask(items));
+}
+
+int get_common_priority(std::uint64_t mask) {
+    return mask == 0 ? 0 : std::countr_zero(mask);
+}
+
+struct rucksack {
+    std::uint64_t first{0};
+    std::uint64_t second{0};
+
+    rucksack() = default;
+
+    rucksack(std::uint64_t first, std::uint64_t second) : first{first}, second{second} {}
+
+    explicit rucksack(std::string_view items) {
+        auto half = items.size() / 2;
+        first = get_item_mask(items.substr(0, half));
+        second = get_item_mask(items.substr(half));
     }
-    return 0;
+
+    [[nodiscard]] std::uint64_t all() const {
+        return first | second;
+    }
+
+    [[nodiscard]] std::uint64_t common() const {
+        return first & second;
+    }
+};
+
+#ifdef HAS_AVX2_KERNEL
+// letter masks of 4 item runs at once, one run per 64 bit lane, every run must be followed by 8 readable bytes
+__attribute__((target("avx2"))) __m256i get_letter_masks_avx2(__m256i starts, __m256i lengths, std::size_t longest) {
+    const auto ones = _mm256_set1_epi64x(-1);
+    const auto low = _mm256_set1_epi64x(0xFF);
+    const auto base = _mm256_set1_epi64x('A');
+    auto mask = _mm256_setzero_si256();
+
+    for (std::size_t pos{0}; pos < longest; pos += 8) {
+        // finished lanes load nothing and read as 0xFF bytes, bytes past the end of a run are forced to 0xFF,
+        // 0xFF - 'A' is above 63 so those bytes shift out and set no bit
+        auto at = _mm256_set1_epi64x(static_cast<long long>(pos));
+        auto left = _mm256_sub_epi64(lengths, at);
+        auto live = _mm256_cmpgt_epi64(left, _mm256_setzero_si256());
+        auto items = _mm256_mask_i64gather_epi64(ones, nullptr, _mm256_add_epi64(starts, at), live, 1);
+        items = _mm256_or_si256(items, _mm256_sllv_epi64(ones, _mm256_slli_epi64(left, 3)));
+
+        for (int b{0}; b < 8; b++) {
+            auto letter = _mm256_sub_epi64(_mm256_and_si256(items, low), base);
+            mask = _mm256_or_si256(mask, _mm256_sllv_epi64(_mm256_set1_epi64x(1), letter));
+            items = _mm256_srli_epi64(items, 8);
+        }
+    }
+    return mask;
+}
+
+// 4 rucksacks per pass, one per lane, items must be followed by at least 8 readable bytes
+__attribute__((target("avx2"))) void make_rucksacks_avx2(std::span<const std::string_view> lines, std::span<rucksack> out) {
+    std::size_t i{0};
+    for (; i + 4 <= lines.size(); i += 4) {
+        alignas(32) long long firstStarts[4];
+        alignas(32) long long secondStarts[4];
+        alignas(32) long long firstLens[4];
+        alignas(32) long long secondLens[4];
+        std::size_t longest{0};
+        for (std::size_t k{0}; k < 4; k++) {
+            auto line = lines[i + k];
+            auto half = line.size() / 2;
+            firstStarts[k] = reinterpret_cast<long long>(line.data());
+            secondStarts[k] = reinterpret_cast<long long>(line.data() + half);
+            firstLens[k] = static_cast<long long>(half);
+            secondLens[k] = static_cast<long long>(line.size() - half);
+            longest = std::max(longest, line.size() - half);
+        }
+
+        auto first = get_letter_masks_avx2(_mm256_load_si256(reinterpret_cast<const __m256i*>(firstStarts)),
+            _mm256_load_si256(reinterpret_cast<const __m256i*>(firstLens)), longest);
+        auto second = get_letter_masks_avx2(_mm256_load_si256(reinterpret_cast<const __m256i*>(secondStarts)),
+            _mm256_load_si256(reinterpret_cast<const __m256i*>(secondLens)), longest);
+
+        alignas(32) std::uint64_t firstMasks[4];
+        alignas(32) std::uint64_t secondMasks[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(firstMasks), first);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(secondMasks), second);
+        for (std::size_t k{0}; k < 4; k++)
+            out[i + k] = {to_priority_mask(firstMasks[k]), to_priority_mask(secondMasks[k])};
+    }
+
+    for (; i < lines.size(); i++)
+        out[i] = rucksack{lines[i]};
+}
+
+// 4 groups per pass, one per lane, each lane gathers and ANDs the masks of its group
+__attribute__((target("avx2"))) int get_group_priority_avx2(std::span<const rucksack> sacks, std::size_t groupSize) {
+    static_assert(sizeof(rucksack) == 2 * sizeof(std::uint64_t));
+    const auto stride = static_cast<long long>(groupSize * 2);
+    const auto* masks = reinterpret_cast<const long long*>(sacks.data());
+    auto groups = sacks.size() / groupSize;
+    auto priority{0};
+
+    std::size_t g{0};
+    for (; g + 4 <= groups; g += 4) {
+        auto index = _mm256_setr_epi64x(0, stride, stride * 2, stride * 3);
+        auto common = _mm256_set1_epi64x(-1);
+        for (std::size_t j{0}; j < groupSize; j++) {
+            const auto* row = masks + (g * groupSize + j) * 2;
+            auto first = _mm256_i64gather_epi64(row, index, 8);
+            auto second = _mm256_i64gather_epi64(row + 1, index, 8);
+            common = _mm256_and_si256(common, _mm256_or_si256(first, second));
+        }
+
+        alignas(32) std::uint64_t lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), common);
+        for (auto lane : lanes)
+            priority += get_common_priority(lane);
+    }
+
+    for (; g < groups; g++) {
+        auto mask = ~std::uint64_t{0};
+        for (std::size_t j{g * groupSize}; j < (g + 1) * groupSize; j++)
+            mask &= sacks[j].all();
+        priority += get_common_priority(mask);
+    }
+    return priority;
+}
+#endif
+
+using rucksack_builder = void (*)(std::span<const std::string_view>, std::span<rucksack>);
+using group_reducer = int (*)(std::span<const rucksack>, std::size_t);
+
+void make_rucksacks(std::span<const std::string_view> lines, std::span<rucksack> out) {
+    for (std::size_t i{0}; i < lines.size(); i++)
+        out[i] = rucksack{lines[i]};
 }
 
-std::vector<std::string> get_input(const std::string& filename) {
-    std::ifstream input{filename};
-    std::string line;
+int get_group_priority(std::span<const rucksack> sacks, std::size_t groupSize) {
+    auto priority{0};
+    for (std::size_t i{groupSize}; i <= sacks.size(); i += groupSize) {
+        auto mask = ~std::uint64_t{0};
+        for (std::size_t j{i - groupSize}; j < i; j++)
+            mask &= sacks[j].all();
+        priority += get_common_priority(mask);
+    }
+    return priority;
+}
+
+rucksack_builder select_rucksack_builder() {
+#ifdef HAS_AVX2_KERNEL
+    if (__builtin_cpu_supports("avx2"))
+        return make_rucksacks_avx2;
+#endif
+    return make_rucksacks;
+}
+
+group_reducer select_group_reducer() {
+#ifdef HAS_AVX2_KERNEL
+    if (__builtin_cpu_supports("avx2"))
+        return get_group_priority_avx2;
+#endif
+    return get_group_priority;
+}
+
+int get_compartment_priority(std::span<const rucksack> sacks) {
+    auto priority{0};
+    for (const auto& sack : sacks)
+        priority += get_common_priority(sack.common());
+    return priority;
+}
+
+// whole input in one buffer, padded so block kernels can read past the last line
+std::string get_buffer(const std::string& filename) {
+    std::ifstream input{filename, std::ios::binary};
+    std::string result{std::istreambuf_iterator<char>{input}, std::istreambuf_iterator<char>{}};
+    result.append(BlockPadding, '\0');
+    return result;
+}
+
+std::vector<std::string_view> get_lines(std::string_view buffer) {
+    buffer = buffer.substr(0, buffer.size() - BlockPadding);
+    std::vector<std::string_view> result;
+    while (!buffer.empty()) {
+        auto eol = std::min(buffer.find('\n'), buffer.size());
+        result.push_back(buffer.substr(0, eol));
+        buffer.remove_prefix(std::min(eol + 1, buffer.size()));
+    }
+    return result;
+}
+
+std::vector<rucksack> get_input(std::span<const std::string_view> lines, rucksack_builder build) {
+    std::vector<rucksack> result(lines.size());
+    build(lines, result);
+    return result;
+}
+
+// every group shares exactly one badge, any other item is missing from at least one rucksack,
+// the badge is also the only item both compartments of a rucksack share
+std::vector<std::string> make_groups(std::size_t groups, std::size_t groupSize, std::size_t sackSize, std::mt19937& rng) {
+    const std::string_view items{"abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ"};
     std::vector<std::string> result;
+    result.reserve(groups * groupSize);
+
+    for (std::size_t g{0}; g < groups; g++) {
+        auto badge = items[rng() % items.size()];
+        std::vector<char> excluded(items.size());
+        for (auto& e : excluded)
+            e = static_cast<char>(rng() % groupSize);
 
-    while (std::getline(input, line))
-        result.push_back(line);
+        for (std::size_t j{0}; j < groupSize; j++) {
+            std::string allowed;
+            for (std::size_t k{0}; k < items.size(); k++) {
+                if (items[k] != badge && static_cast<std::size_t>(excluded[k]) != j)
+                    allowed += items[k];
+            }
 
+            // the compartments draw from disjoint halves of the allowed items so the badge is their only common item
+            std::shuffle(allowed.begin(), allowed.end(), rng);
+            auto split = allowed.size() / 2;
+            auto half = sackSize / 2;
+            std::string sack(sackSize, badge);
+            for (std::size_t k{0}; k < sackSize; k++) {
+                if (rng() % 8 != 0)
+                    sack[k] = k < half ? allowed[rng() % split] : allowed[split + rng() % (allowed.size() - split)];
+            }
+            sack[rng() % half] = badge;
+            sack[half + rng() % (sackSize - half)] = badge;
+            result.push_back(std::move(sack));
+        }
+    }
     return result;
 }
 
-int main() {
-    auto input = get_input("input.txt");
+template <typename Func>
+double time_ms(Func&& func) {
+    auto start = std::chrono::steady_clock::now();
+    func();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
 
-    // part 1
-    auto priority{0};
-    for (const auto& line : input) {
-        auto half = line.size() / 2;
-        auto c = get_common_char(line.substr(0, half), line.substr(half));
-        priority += get_priority(c);
+// every column computes both parts, find scans each compartment and group with string searches
+void run_benchmark() {
+    const std::size_t totalSacks{1 << 17};
+    const std::size_t sackSize{48};
+    std::mt19937 rng{2022};
+
+    std::cout << "group   find (ms)   mask (ms)   avx2 (ms)   result\n";
+    for (std::size_t groupSize : {2, 3, 4, 8, 16, 32, 64}) {
+        auto sacks = make_groups(totalSacks / groupSize, groupSize, sackSize, rng);
+        std::string buffer;
+        for (const auto& sack : sacks)
+            buffer += sack + '\n';
+        buffer.append(BlockPadding, '\0');
+        auto lines = get_lines(buffer);
+
+        std::pair findResult{0, 0};
+        auto findMs = time_ms([&] {
+            for (const auto& sack : sacks) {
+                std::string_view items{sack};
+                auto half = items.size() / 2;
+                auto second = items.substr(half);
+                for (auto c : items.substr(0, half)) {
+                    if (second.find(c) != std::string_view::npos) {
+                        findResult.first += get_priority(c);
+                        break;
+                    }
+                }
+            }
+
+            std::span<const std::string> all{sacks};
+            for (std::size_t i{0}; i + groupSize <= all.size(); i += groupSize)
+                findResult.second += get_priority(get_common_char(all.subspan(i, groupSize)));
+        });
+
+        std::pair maskResult{0, 0};
+        auto maskMs = time_ms([&] {
+            auto input = get_input(lines, make_rucksacks);
+            maskResult = {get_compartment_priority(input), get_group_priority(input, groupSize)};
+        });
+
+        std::pair simdResult{0, 0};
+        auto simdMs = time_ms([&] {
+            auto input = get_input(lines, select_rucksack_builder());
+            simdResult = {get_compartment_priority(input), select_group_reducer()(input, groupSize)};
+        });
+
+        auto match = findResult == maskResult && maskResult == simdResult;
+        std::printf("%5zu %11.2f %11.2f %11.2f   %s\n", groupSize, findMs, maskMs, simdMs, match ? "ok" : "MISMATCH");
     }
-    std::cout << priority << '\n';
+}
 
-    // part 2
-    priority = 0;
-    for (std::size_t i{3}; i < input.size() + 3; i += 3) {
-        auto c = get_common_char(input[i - 3], input[i - 2], input[i - 1]);
-        priority += get_priority(c);
+int main(int argc, char* argv[]) {
+    std::size_t groupSize{3};
+    if (argc > 1) {
+        if (std::string_view{argv[1]} == "--bench") {
+            run_benchmark();
+            return 0;
+        }
+        groupSize = std::stoul(argv[1]);
+        if (groupSize == 0) {
+            std::cerr << "group size must be at least 1\n";
+            return 1;
+        }
     }
-    std::cout << priority << '\n';
+
+    auto buffer = get_buffer("input.txt");
+    auto input = get_input(get_lines(buffer), select_rucksack_builder());
+
+    // part 1
+    std::cout << get_compartment_priority(input) << '\n';
+
+    // part 2
+    std::cout << select_group_reducer()(input, groupSize) << '\n';
     return 0;
 }
@@ -1,8 +1,14 @@
+#include <algorithm>
+#include <charconv>
 #include <fstream>
 #include <iostream>
-#include <ranges>
+#include <iterator>
+#include <limits>
+#include <optional>
 #include <string>
 #include <string_view>
+#include <system_error>
+#include <utility>
 #include <vector>
 
 struct section {
@@ -20,54 +26,212 @@ struct section {
             || (start >= another.start && start <= another.end)
             || (end >= another.start && end <= another.end);
     }
+
+    [[nodiscard]] bool contains(const section& another) const {
+        return start <= another.start && end >= another.end;
+    }
 };
 
-std::vector<std::string> split_str(const std::string& input, char delim) {
-    auto split = input
-        | std::ranges::views::split(delim)
-        | std::ranges::views::transform([](auto&& str) { return std::string(&*str.begin(), std::ranges::distance(str)); });
+// sections sorted by start, viewed as an implicit balanced tree where each midpoint stores its subtree's max end
+struct section_index {
+    std::vector<section> by_start;
+    std::vector<int> max_end;
+    std::vector<int> ends;
+
+    explicit section_index(std::vector<section> sections) : by_start{std::move(sections)} {
+        std::ranges::sort(by_start, {}, &section::start);
+        max_end.resize(by_start.size());
+        build(0, by_start.size());
+
+        ends.reserve(by_start.size());
+        for (const auto& sec : by_start)
+            ends.push_back(sec.end);
+        std::ranges::sort(ends);
+    }
+
+    // number of sections sharing at least one id with another, O(log n)
+    [[nodiscard]] std::size_t count_overlaps(const section& another) const {
+        auto startsAfter = by_start.end() - std::ranges::upper_bound(by_start, another.end, {}, &section::start);
+        auto endsBefore = std::ranges::lower_bound(ends, another.start) - ends.begin();
+        return by_start.size() - static_cast<std::size_t>(startsAfter + endsBefore);
+    }
+
+    // for_each_overlap and for_each_container are O((k + 1) log n) for k results, not O(log n + k): subtrees
+    // that end before the query are pruned, but each reported section can still cost a root to leaf descent
+    template <typename Func>
+    void for_each_overlap(const section& another, Func&& func) const {
+        visit(0, by_start.size(), another.start, another.end, [&](const section& sec) {
+            if (sec.partial_contain(another))
+                func(sec);
+        });
+    }
 
-    return std::vector<std::string>{split.begin(), split.end()};
+    template <typename Func>
+    void for_each_container(const section& another, Func&& func) const {
+        visit(0, by_start.size(), another.end, another.start, [&](const section& sec) {
+            if (sec.contains(another))
+                func(sec);
+        });
+    }
+
+    // number of unordered pairs of sections that overlap, O(n log n)
+    [[nodiscard]] std::size_t overlapping_pairs() const {
+        std::size_t result{0};
+        for (std::size_t i{0}; i < by_start.size(); i++) {
+            auto later = std::upper_bound(by_start.begin() + static_cast<std::ptrdiff_t>(i) + 1, by_start.end(), by_start[i].end,
+                [](int value, const section& sec) { return value < sec.start; });
+            result += static_cast<std::size_t>(later - by_start.begin()) - i - 1;
+        }
+        return result;
+    }
+
+private:
+    int build(std::size_t lo, std::size_t hi) {
+        if (lo >= hi)
+            return std::numeric_limits<int>::min();
+
+        auto mid = lo + (hi - lo) / 2;
+        max_end[mid] = std::max({by_start[mid].end, build(lo, mid), build(mid + 1, hi)});
+        return max_end[mid];
+    }
+
+    // visits sections with start <= maxStart whose subtree reaches minEnd
+    template <typename Func>
+    void visit(std::size_t lo, std::size_t hi, int minEnd, int maxStart, Func&& func) const {
+        if (lo >= hi)
+            return;
+
+        auto mid = lo + (hi - lo) / 2;
+        if (max_end[mid] < minEnd)
+            return;
+
+        visit(lo, mid, minEnd, maxStart, func);
+        if (by_start[mid].start > maxStart)
+            return;
+
+        func(by_start[mid]);
+        visit(mid + 1, hi, minEnd, maxStart, func);
+    }
+};
+
+std::string get_buffer(const std::string& filename) {
+    std::ifstream input{filename, std::ios::binary};
+    return std::string{std::istreambuf_iterator<char>{input}, std::istreambuf_iterator<char>{}};
 }
 
-std::vector<std::string> get_input(const std::string& filename) {
-    std::ifstream input{filename};
-    std::string line;
-    std::vector<std::string> result;
-    while (std::getline(input, line))
-        result.push_back(line);
+// parses one "a-b,c-d" line, a trailing '\r' is allowed, returns false on malformed input
+bool parse_sections(std::string_view line, std::pair<section, section>& out) {
+    if (line.ends_with('\r'))
+        line.remove_suffix(1);
+
+    const char separators[]{'-', ',', '-', '\0'};    // '\0' marks the end of the line
+    auto first = line.data();
+    auto last = first + line.size();
+    int values[4];
+    for (std::size_t i{0}; i < 4; i++) {
+        auto [ptr, ec] = std::from_chars(first, last, values[i]);
+        auto separator = ptr == last ? '\0' : *ptr;
+        if (ec != std::errc{} || separator != separators[i] || (separator == '\0' && ptr != last))
+            return false;
+        if (separator != '\0')
+            first = ptr + 1;
+    }
+
+    out = {section{values[0], values[1]}, section{values[2], values[3]}};
+    return true;
+}
+
+// malformed lines are reported and skipped, blank lines are ignored
+std::vector<std::pair<section, section>> get_input(std::string_view buffer) {
+    std::vector<std::pair<section, section>> result;
+    result.reserve(std::ranges::count(buffer, '\n') + 1);
+
+    std::pair<section, section> sections{section{0, 0}, section{0, 0}};
+    for (std::size_t lineNo{1}; !buffer.empty(); lineNo++) {
+        auto eol = std::min(buffer.find('\n'), buffer.size());
+        auto line = buffer.substr(0, eol);
+        buffer.remove_prefix(std::min(eol + 1, buffer.size()));
+
+        if (line.empty() || line == "\r")
+            continue;
+        if (parse_sections(line, sections))
+            result.push_back(sections);
+        else
+            std::cerr << "line " << lineNo << ": skipping malformed \"" << line << "\"\n";
+    }
 
     return result;
 }
 
-std::pair<section, section> get_sections(const std::string& input) {
-    auto sections = split_str(input, ',');
-    auto firstSplit = split_str(sections[0], '-');
-    auto secondSplit = split_str(sections[1], '-');
-    section first{std::stoi(firstSplit[0]), std::stoi(firstSplit[1])};
-    section second{std::stoi(secondSplit[0]), std::stoi(secondSplit[1])};
-    return std::make_pair(first, second);
+// "a-b" is the section a to b, a lone "a" is the single id section a to a, reversed or malformed queries are rejected
+std::optional<section> parse_query(std::string_view query) {
+    auto dash = std::min(query.find('-', 1), query.size());
+    auto start{0};
+    auto [startEnd, startEc] = std::from_chars(query.data(), query.data() + dash, start);
+    if (startEc != std::errc{} || startEnd != query.data() + dash)
+        return std::nullopt;
+
+    auto end{start};
+    if (dash < query.size()) {
+        auto [endEnd, endEc] = std::from_chars(query.data() + dash + 1, query.data() + query.size(), end);
+        if (endEc != std::errc{} || endEnd != query.data() + query.size())
+            return std::nullopt;
+    }
+
+    if (start > end)
+        return std::nullopt;
+    return section{start, end};
+}
+
+int run_queries(const std::vector<std::pair<section, section>>& input, int argc, char* argv[]) {
+    std::vector<section> queries;
+    for (int i{1}; i < argc; i++) {
+        auto query = parse_query(argv[i]);
+        if (!query) {
+            std::cerr << argv[i] << ": expected a section \"a-b\" with a <= b\n";
+            return 1;
+        }
+        queries.push_back(*query);
+    }
+
+    std::vector<section> sections;
+    sections.reserve(input.size() * 2);
+    for (const auto& [first, second] : input) {
+        sections.push_back(first);
+        sections.push_back(second);
+    }
+
+    section_index index{std::move(sections)};
+    std::cout << "overlapping pairs: " << index.overlapping_pairs() << '\n';
+    for (std::size_t i{0}; i < queries.size(); i++) {
+        const auto& query = queries[i];
+        const auto* arg = argv[i + 1];
+        std::cout << arg << " overlaps " << index.count_overlaps(query) << ':';
+        index.for_each_overlap(query, [](const section& sec) { std::cout << ' ' << sec.start << '-' << sec.end; });
+        std::cout << '\n' << arg << " contained by:";
+        index.for_each_container(query, [](const section& sec) { std::cout << ' ' << sec.start << '-' << sec.end; });
+        std::cout << '\n';
+    }
+    return 0;
 }
 
-int main() {
-    auto input = get_input("input.txt");
-    auto result{0};
+int main(int argc, char* argv[]) {
+    auto buffer = get_buffer("input.txt");
+    auto input = get_input(buffer);
+    if (argc > 1)
+        return run_queries(input, argc, argv);
 
-    // part 1
-    for (const auto& line : input) {
-        auto sections = get_sections(line);
-        if (sections.first.full_contain(sections.second))
-            result++;
+    auto fullCount{0};
+    auto partialCount{0};
+    for (const auto& [first, second] : input) {
+        fullCount += first.full_contain(second);
+        partialCount += first.partial_contain(second);
     }
-    std::cout << result << '\n';
+
+    // part 1
+    std::cout << fullCount << '\n';
 
     // part 2
-    result = 0;
-    for (const auto& line : input) {
-        auto sections = get_sections(line);
-        if (sections.first.partial_contain(sections.second))
-            result++;
-    }
-    std::cout << result << '\n';
+    std::cout << partialCount << '\n';
     return 0;
 }
@@ -1,35 +1,43 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
-#include <regex>
-#include <stack>
+#include <iterator>
+#include <random>
 #include <string>
+#include <string_view>
+#include <system_error>
 #include <vector>
 
+// top of the stack is the back of the vector
 struct stack_of_crates {
-    std::stack<char> crates{};
+    std::vector<char> crates{};
+
+    [[nodiscard]] char top() const {
+        return crates.back();
+    }
 
     void move_to(stack_of_crates& another, int count) {
-        auto counter{0};
-        while (!crates.empty() && counter < count) {
-            another.crates.push(crates.top());
-            crates.pop();
-            counter++;
-        }
+        if (&another == this)
+            return;
+
+        auto moved = std::min(static_cast<std::size_t>(count), crates.size());
+        auto first = crates.end() - static_cast<std::ptrdiff_t>(moved);
+        another.crates.insert(another.crates.end(), std::make_reverse_iterator(crates.end()), std::make_reverse_iterator(first));
+        crates.erase(first, crates.end());
     }
 
     void keep_order_move_to(stack_of_crates& another, int count) {
-        auto counter{0};
-        std::stack<char> tmp;
-        while (!crates.empty() && counter < count) {
-            tmp.push(crates.top());
-            crates.pop();
-            counter++;
-        }
+        if (&another == this)
+            return;
 
-        while (!tmp.empty()) {
-            another.crates.push(tmp.top());
-            tmp.pop();
-        }
+        auto moved = std::min(static_cast<std::size_t>(count), crates.size());
+        auto first = crates.end() - static_cast<std::ptrdiff_t>(moved);
+        another.crates.insert(another.crates.end(), first, crates.end());
+        crates.erase(first, crates.end());
     }
 };
 
@@ -48,26 +56,38 @@ std::vector<stack_of_crates> parse_header(const std::vector<std::string>& lines)
     for (std::size_t i{lines.size() - 1}; !stop; i--) {     // ignore last line in header
         for (std::size_t j{0}; j < lines[i].size(); j++) {
             if (lines[i][j] >= 'A' && lines[i][j] <= 'Z')
-                result[(j - 1) / 4].crates.push(lines[i][j]);
+                result[(j - 1) / 4].crates.push_back(lines[i][j]);
         }
         stop = i == 0;
     }
     return result;
 }
 
+// decodes "move N from A to B" by reading the three numbers in order, returns false if any is missing
+bool parse_instruction(std::string_view line, instruction& out) {
+    int values[3];
+    auto first = line.data();
+    auto last = line.data() + line.size();
+    for (auto& value : values) {
+        first = std::find_if(first, last, [](char c) { return c >= '0' && c <= '9'; });
+        auto [ptr, ec] = std::from_chars(first, last, value);
+        if (ec != std::errc{})
+            return false;
+        first = ptr;
+    }
+
+    out = instruction{values[0], values[1] - 1, values[2] - 1};      // 0 based index
+    return true;
+}
+
 std::vector<instruction> parse_instructions(const std::vector<std::string>& lines) {
     std::vector<instruction> result;
     result.reserve(lines.size());
 
-    std::regex rgx{R"(move (\d+) from (\d+) to (\d+))"};
-    std::smatch match;
+    instruction ins;
     for (const auto& line : lines) {
-        if (std::regex_search(line, match, rgx)) {
-            auto moves = std::stoi(match[1].str());
-            auto from = std::stoi(match[2].str()) - 1;      // 0 based index
-            auto to = std::stoi(match[3].str()) - 1;        // 0 based index
-            result.push_back(instruction{moves, from, to});
-        }
+        if (parse_instruction(line, ins))
+            result.push_back(ins);
     }
     return result;
 }
@@ -84,27 +104,139 @@ std::vector<std::string> get_input(std::ifstream& input, bool isHeader) {
     return lines;
 }
 
-int main() {
-    std::ifstream input{"input.txt"};
+void simulate(std::vector<stack_of_crates>& crates, const std::vector<instruction>& instructions, bool keepOrder) {
+    for (const auto& ins : instructions) {
+        if (keepOrder)
+            crates[ins.from].keep_order_move_to(crates[ins.to], ins.moves);
+        else
+            crates[ins.from].move_to(crates[ins.to], ins.moves);
+    }
+}
 
-    // part 1
-    auto header = get_input(input, true);
-    auto crates = parse_header(header);
+std::string get_tops(const std::vector<stack_of_crates>& crates) {
+    std::string result;
+    for (const auto& stc : crates) {
+        if (!stc.crates.empty())
+            result += stc.top();
+    }
+    return result;
+}
 
+// walks the instructions backwards from each final top to find the original crate, never moving any crates
+std::string trace_tops(const std::vector<stack_of_crates>& crates, const std::vector<instruction>& instructions, bool keepOrder) {
+    // only stack heights are simulated forwards, to know how many crates each move actually took
+    std::vector<std::size_t> heights;
+    heights.reserve(crates.size());
+    for (const auto& stc : crates)
+        heights.push_back(stc.crates.size());
+
+    std::vector<std::size_t> moved(instructions.size());
+    for (std::size_t i{0}; i < instructions.size(); i++) {
+        const auto& ins = instructions[i];
+        auto count = ins.from == ins.to ? 0 : std::min(static_cast<std::size_t>(ins.moves), heights[ins.from]);
+        heights[ins.from] -= count;
+        heights[ins.to] += count;
+        moved[i] = count;
+    }
+
+    std::string result;
+    for (std::size_t s{0}; s < crates.size(); s++) {
+        if (heights[s] == 0)
+            continue;
+
+        auto stack = s;
+        std::size_t depth{0};       // 0 is the top of the stack
+        for (auto i = instructions.size(); i-- > 0;) {
+            auto from = static_cast<std::size_t>(instructions[i].from);
+            auto to = static_cast<std::size_t>(instructions[i].to);
+            auto count = moved[i];
+            if (count == 0)
+                continue;
+
+            if (stack == to && depth < count) {
+                stack = from;
+                depth = keepOrder ? depth : count - 1 - depth;
+            } else if (stack == to) {
+                depth -= count;
+            } else if (stack == from) {
+                depth += count;
+            }
+        }
+        result += crates[stack].crates[crates[stack].crates.size() - 1 - depth];
+    }
+    return result;
+}
+
+template <typename Func>
+double time_ms(Func&& func) {
+    auto start = std::chrono::steady_clock::now();
+    func();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void run_benchmark() {
+    const std::size_t numStacks{9};
+    const std::size_t cratesPerStack{2'000'000};
+    const std::size_t numInstructions{500};
+    std::mt19937 rng{2022};
+
+    std::vector<stack_of_crates> crates(numStacks);
+    for (auto& stc : crates) {
+        stc.crates.resize(cratesPerStack);
+        for (auto& c : stc.crates)
+            c = static_cast<char>('A' + rng() % 26);
+    }
+
+    std::vector<instruction> instructions;
+    instructions.reserve(numInstructions);
+    for (std::size_t i{0}; i < numInstructions; i++) {
+        auto from = static_cast<int>(rng() % numStacks);
+        auto to = static_cast<int>((from + 1 + rng() % (numStacks - 1)) % numStacks);
+        instructions.push_back(instruction{static_cast<int>(rng() % (2 * cratesPerStack)), from, to});
+    }
+
+    std::cout << "part   simulate (ms)   trace (ms)   result\n";
+    for (auto keepOrder : {false, true}) {
+        std::string simulated;
+        auto simulateMs = time_ms([&] {
+            auto copy = crates;
+            simulate(copy, instructions, keepOrder);
+            simulated = get_tops(copy);
+        });
+
+        std::string traced;
+        auto traceMs = time_ms([&] { traced = trace_tops(crates, instructions, keepOrder); });
+        std::printf("%4d %15.2f %12.3f   %s\n", keepOrder ? 2 : 1, simulateMs, traceMs, simulated == traced ? "ok" : "MISMATCH");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    auto trace = argc > 1 && std::string_view{argv[1]} == "--trace";
+    if (argc > 1 && std::string_view{argv[1]} == "--bench") {
+        run_benchmark();
+        return 0;
+    }
+
+    std::ifstream input{"input.txt"};
+    auto header = get_input(input, true);
+    const auto snapshot = parse_header(header);
     auto moves = get_input(input, false);
     auto instructions = parse_instructions(moves);
-    for (const auto& ins : instructions)
-        crates[ins.from].move_to(crates[ins.to], ins.moves);
-    for (const auto& stc : crates)
-        std::cout << stc.crates.top();
-    std::cout << '\n';
+    if (trace) {
+        std::cout << trace_tops(snapshot, instructions, false) << '\n';
+        std::cout << trace_tops(snapshot, instructions, true);
+        return 0;
+    }
+
+    // part 1
+    auto crates = snapshot;
+    simulate(crates, instructions, false);
+    std::cout << get_tops(crates) << '\n';
 
     // part 2
-    crates = parse_header(header);
-    for (const auto& ins : instructions)
-        crates[ins.from].keep_order_move_to(crates[ins.to], ins.moves);
-    for (const auto& stc : crates)
-        std::cout << stc.crates.top();
+    crates = snapshot;
+    simulate(crates, instructions, true);
+    std::cout << get_tops(crates);
 
     return 0;
 }
@@ -1,9 +1,31 @@
 #include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <optional>
 #include <string>
+#include <random>
+#include <string_view>
 #include <vector>
 
+#include <unistd.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define HAS_AVX2_KERNEL 1
+#include <immintrin.h>
+#endif
+
+const auto StreamBlockSize = 1 << 16;
+const std::size_t PrefixBlockSize = 4096;
+const std::size_t PrefixLead = 64;
+
 std::string get_input(const std::string& filename) {
     std::ifstream input{filename};
     std::string line;
@@ -11,7 +33,184 @@ std::string get_input(const std::string& filename) {
     return line;
 }
 
-std::size_t get_sig_idx(const std::string& input, std::size_t uniqCount) {
+// per byte counts of a sliding window, dups is the number of surplus copies inside the window
+struct window_tracker {
+    std::size_t window;
+    std::array<std::uint32_t, 256> counts{};
+    std::size_t dups{0};
+    std::size_t seen{0};
+    bool distinct{false};
+
+    explicit window_tracker(std::size_t window) : window{window} {}
+
+    // adds a byte and drops the one leaving the window, returns true when the window has just become distinct
+    bool push(unsigned char in, unsigned char out) {
+        dups += counts[in]++ > 0;
+        if (seen >= window)
+            dups -= --counts[out] > 0;
+
+        seen++;
+        auto wasDistinct = distinct;
+        distinct = seen >= window && dups == 0;
+        return distinct && !wasDistinct;
+    }
+};
+
+std::size_t get_sig_idx(std::string_view input, std::size_t window) {
+    window_tracker tracker{window};
+    for (std::size_t i{0}; i < input.size(); i++) {
+        auto out = i >= window ? input[i - window] : 0;
+        if (tracker.push(static_cast<unsigned char>(input[i]), static_cast<unsigned char>(out)))
+            return i + 1;
+    }
+    return 0;
+}
+
+#ifdef HAS_AVX2_KERNEL
+// window ending at i is distinct when popcount(P[i] ^ P[i - window]) == window, P being the prefix xor of 1 << (c & 31)
+// only valid for 'a' to 'z', windows above 26 never match
+__attribute__((target("avx2"))) std::size_t get_sig_idx_avx2(std::string_view input, std::size_t window) {
+    if (window == 0 || window > PrefixLead)
+        return get_sig_idx(input, window);
+
+    alignas(32) std::uint32_t prefix[PrefixLead + PrefixBlockSize]{};
+    const auto one = _mm256_set1_epi32(1);
+    const auto letterBits = _mm256_set1_epi32(31);
+    const auto highHalf = _mm256_setr_epi32(0, 0, 0, 0, -1, -1, -1, -1);
+    const auto nibbles = _mm256_set1_epi8(0x0F);
+    const auto popLut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const auto target = _mm256_set1_epi32(static_cast<int>(window));
+    auto carry = _mm256_setzero_si256();
+
+    for (std::size_t base{0}; base < input.size(); base += PrefixBlockSize) {
+        auto count = std::min(PrefixBlockSize, input.size() - base);
+        for (std::size_t j{0}; j < count; j += 8) {
+            std::uint64_t bytes{0};
+            std::memcpy(&bytes, input.data() + base + j, std::min<std::size_t>(8, count - j));
+            auto bits = _mm256_sllv_epi32(one, _mm256_and_si256(_mm256_cvtepu8_epi32(_mm_cvtsi64_si128(static_cast<long long>(bytes))), letterBits));
+
+            // prefix xor across the 8 lanes, then continue from the previous lanes
+            bits = _mm256_xor_si256(bits, _mm256_slli_si256(bits, 4));
+            bits = _mm256_xor_si256(bits, _mm256_slli_si256(bits, 8));
+            bits = _mm256_xor_si256(bits, _mm256_and_si256(_mm256_permutevar8x32_epi32(bits, _mm256_set1_epi32(3)), highHalf));
+            bits = _mm256_xor_si256(bits, carry);
+            carry = _mm256_permutevar8x32_epi32(bits, _mm256_set1_epi32(7));
+            _mm256_store_si256(reinterpret_cast<__m256i*>(prefix + PrefixLead + j), bits);
+        }
+
+        for (std::size_t j{0}; j < count; j += 8) {
+            auto current = _mm256_load_si256(reinterpret_cast<const __m256i*>(prefix + PrefixLead + j));
+            auto previous = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prefix + PrefixLead + j - window));
+            auto xored = _mm256_xor_si256(current, previous);
+
+            auto low = _mm256_shuffle_epi8(popLut, _mm256_and_si256(xored, nibbles));
+            auto high = _mm256_shuffle_epi8(popLut, _mm256_and_si256(_mm256_srli_epi16(xored, 4), nibbles));
+            auto bytes = _mm256_add_epi8(low, high);
+            auto pop = _mm256_madd_epi16(_mm256_maddubs_epi16(bytes, _mm256_set1_epi8(1)), _mm256_set1_epi16(1));
+
+            auto found = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(pop, target))));
+            if (found != 0) {
+                auto idx = j + static_cast<std::size_t>(std::countr_zero(found));
+                if (idx < count)
+                    return base + idx + 1;
+            }
+        }
+
+        // keep the last prefixes for windows reaching back into this block
+        std::memcpy(prefix, prefix + PrefixBlockSize, PrefixLead * sizeof *prefix);
+    }
+    return 0;
+}
+#endif
+
+using sig_finder = std::size_t (*)(std::string_view, std::size_t);
+
+sig_finder select_sig_finder() {
+#ifdef HAS_AVX2_KERNEL
+    if (__builtin_cpu_supports("avx2"))
+        return get_sig_idx_avx2;
+#endif
+    return get_sig_idx;
+}
+
+// tracks several window sizes over an unbounded stream, keeping only the last bytes of the largest window
+struct marker_scanner {
+    std::vector<window_tracker> trackers;
+    std::vector<unsigned char> history;
+    std::size_t offset{0};
+
+    explicit marker_scanner(const std::vector<std::size_t>& windows) {
+        for (auto window : windows)
+            trackers.emplace_back(window);
+        history.resize(std::bit_ceil(std::max<std::size_t>(std::ranges::max(windows), 1)));
+    }
+
+    // calls onMarker(window, offset) each time a window becomes distinct, offset is the count of bytes read so far
+    template <typename Func>
+    void feed(std::string_view block, Func&& onMarker) {
+        auto mask = history.size() - 1;
+        for (auto c : block) {
+            auto in = static_cast<unsigned char>(c);
+            for (auto& tracker : trackers) {
+                if (tracker.push(in, history[(offset - tracker.window) & mask]))
+                    onMarker(tracker.window, offset + 1);
+            }
+            history[offset & mask] = in;
+            offset++;
+        }
+    }
+};
+
+// the whole of text must be a number in [min, max]
+template <typename T>
+std::optional<T> parse_arg(std::string_view text, T min, T max) {
+    T value{};
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc{} || end != text.data() + text.size() || value < min || value > max)
+        return std::nullopt;
+    return value;
+}
+
+// usage: day6 --stream [--fd N] window..., a marker needs window distinct bytes so windows are 1 to 256
+int run_stream(int argc, char* argv[]) {
+    auto fd{STDIN_FILENO};
+    std::vector<std::size_t> windows;
+    for (int i{2}; i < argc; i++) {
+        if (std::string_view{argv[i]} == "--fd" && i + 1 < argc) {
+            auto parsed = parse_arg(argv[++i], 0, std::numeric_limits<int>::max());
+            if (!parsed) {
+                std::cerr << argv[i] << ": not a file descriptor\n";
+                return 1;
+            }
+            fd = *parsed;
+            continue;
+        }
+
+        auto window = parse_arg<std::size_t>(argv[i], 1, 256);
+        if (!window) {
+            std::cerr << argv[i] << ": window must be a number from 1 to 256\n";
+            return 1;
+        }
+        windows.push_back(*window);
+    }
+    if (windows.empty())
+        windows = {4, 14};
+
+    marker_scanner scanner{windows};
+    std::vector<char> block(StreamBlockSize);
+    ssize_t count;
+    while ((count = ::read(fd, block.data(), block.size())) > 0) {
+        scanner.feed(std::string_view{block.data(), static_cast<std::size_t>(count)}, [](std::size_t window, std::size_t offset) {
+            std::cout << window << ' ' << offset << '\n';
+        });
+        std::cout.flush();      // markers of each block are visible before blocking on the next read
+    }
+    return count < 0 ? 1 : 0;
+}
+
+// the original implementation, kept as the benchmark baseline
+std::size_t get_sig_idx_sort(const std::string& input, std::size_t window) {
+    auto uniqCount = window - 1;
     for (std::size_t i{uniqCount}; i < input.size(); i++) {
         auto sub = input.substr(i - uniqCount, uniqCount + 1);
         std::sort(sub.begin(), sub.end());
@@ -22,13 +221,59 @@ std::size_t get_sig_idx(const std::string& input, std::size_t uniqCount) {
     return 0;
 }
 
-int main() {
+template <typename Func>
+double time_ms(Func&& func) {
+    auto start = std::chrono::steady_clock::now();
+    func();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// usage: day6 --bench [max bytes], inputs have their only start of message marker at the very end
+void run_benchmark(std::size_t maxSize) {
+    const std::size_t window{14};
+    const std::size_t sortLimit{16 << 20};
+    std::mt19937 rng{2022};
+
+    std::cout << "bytes        sort (ms)   window (ms)   simd (ms)   simd (GB/s)   result\n";
+    for (std::size_t size{4 << 10}; size <= maxSize; size *= 4) {
+        std::string input(size, 'a');
+        for (std::size_t i{0}; i + window < size; i++)
+            input[i] = static_cast<char>('a' + rng() % (window - 1));
+        for (std::size_t i{0}; i < window; i++)
+            input[size - window + i] = static_cast<char>('a' + i);
+
+        std::size_t sorted{size};
+        auto sortMs = size <= sortLimit ? time_ms([&] { sorted = get_sig_idx_sort(input, window); }) : 0.0;
+
+        std::size_t slid{0};
+        auto windowMs = time_ms([&] { slid = get_sig_idx(input, window); });
+
+        std::size_t simd{0};
+        auto simdMs = time_ms([&] { simd = select_sig_finder()(input, window); });
+
+        auto match = slid == size && simd == size && sorted == size;
+        if (size <= sortLimit)
+            std::printf("%-12zu %9.2f %13.2f %11.2f %13.2f   %s\n", size, sortMs, windowMs, simdMs, size / simdMs / 1e6, match ? "ok" : "MISMATCH");
+        else
+            std::printf("%-12zu %9s %13.2f %11.2f %13.2f   %s\n", size, "-", windowMs, simdMs, size / simdMs / 1e6, match ? "ok" : "MISMATCH");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string_view{argv[1]} == "--stream")
+        return run_stream(argc, argv);
+    if (argc > 1 && std::string_view{argv[1]} == "--bench") {
+        run_benchmark(argc > 2 ? std::stoull(argv[2]) : std::size_t{1} << 30);
+        return 0;
+    }
+
     auto input = get_input("input.txt");
+    auto find = select_sig_finder();
 
     // part 1
-    std::cout << get_sig_idx(input, 3) << '\n';
+    std::cout << find(input, 4) << '\n';
 
     // part 2
-    std::cout << get_sig_idx(input, 13) << '\n';
+    std::cout << find(input, 14) << '\n';
     return 0;
 }
@@ -1,54 +1,127 @@
+#include <algorithm>
 #include <cctype>
+#include <charconv>
+#include <cstdint>
 #include <fstream>
+#include <functional>
 #include <iostream>
-#include <map>
-#include <numeric>
+#include <optional>
 #include <string>
-#include <utility>
+#include <string_view>
 #include <vector>
 
-struct file_node {
-    std::string name;
-    std::size_t size;
+const std::size_t InitialSlots = 64;
 
-    file_node(std::string name, std::size_t size)
-        : name{std::move(name)}, size{size} {}
+struct dir_node {
+    std::uint32_t name_offset;      // name is names[name_offset, name_offset + name_length) in file_sys
+    std::uint32_t name_length;
+    std::size_t parent;
+    std::size_t files_size{0};      // files directly in this directory
+    std::size_t total_size{0};      // files in the whole subtree, valid after file_sys::update_totals
+
+    dir_node(std::uint32_t nameOffset, std::uint32_t nameLength, std::size_t parent)
+        : name_offset{nameOffset}, name_length{nameLength}, parent{parent} {}
 };
 
+// directories are ids in creation order, so a parent always comes before its children
+// (parent id, name) pairs are interned through an open addressing table, names live in one arena
 struct file_sys {
-    std::vector<std::string> curr_path;
-    std::map<std::string, std::vector<file_node>> path_map;
+    std::string names{"/"};
+    std::vector<dir_node> dirs{dir_node{0, 1, 0}};
+    std::vector<std::size_t> slots = std::vector<std::size_t>(InitialSlots);       // dir id + 1, 0 is empty
+    std::size_t current{0};
 
-    void add_file(const file_node& file) {
-        for (const auto& path : curr_path)
-            path_map[path].push_back(file);
+    void add_file(std::size_t size) {
+        dirs[current].files_size += size;
     }
 
     void go_root() {
-        curr_path.clear();
-        curr_path.emplace_back("/");
-        path_map.clear();
-        path_map.insert({"/", {}});
+        current = 0;
     }
 
     void go_back() {
-        if (curr_path.size() > 1)
-            curr_path.pop_back();
+        current = dirs[current].parent;
+    }
+
+    void go_dir(std::string_view dir) {
+        current = intern(current, dir);
     }
 
-    void go_dir(const std::string& dir) {
-        auto currName = curr_path.back();
-        auto newName = currName.back() == '/' ? currName + dir : currName + "/" + dir;
-        curr_path.push_back(newName);
-        path_map.insert({newName, {}});
+    [[nodiscard]] std::string_view name(std::size_t dir) const {
+        return std::string_view{names}.substr(dirs[dir].name_offset, dirs[dir].name_length);
     }
 
-    [[nodiscard]] std::size_t sum_size(const std::string& dir) const {
-        std::size_t result{0};
-        for (const auto& file : path_map.at(dir))
-            result += file.size;
+    void update_totals() {
+        for (auto& node : dirs)
+            node.total_size = node.files_size;
+        for (auto i = dirs.size() - 1; i > 0; i--)
+            dirs[dirs[i].parent].total_size += dirs[i].total_size;
+    }
 
-        return result;
+    [[nodiscard]] std::size_t sum_size(std::size_t dir) const {
+        return dirs[dir].total_size;
+    }
+
+private:
+    [[nodiscard]] static std::size_t slot_hash(std::size_t parent, std::string_view dir) {
+        return std::hash<std::string_view>{}(dir) ^ (parent * 0x9E3779B97F4A7C15ull);
+    }
+
+    std::size_t intern(std::size_t parent, std::string_view dir) {
+        auto mask = slots.size() - 1;
+        auto slot = slot_hash(parent, dir) & mask;
+        for (; slots[slot] != 0; slot = (slot + 1) & mask) {
+            auto id = slots[slot] - 1;
+            if (dirs[id].parent == parent && name(id) == dir)
+                return id;
+        }
+
+        auto id = dirs.size();
+        dirs.emplace_back(static_cast<std::uint32_t>(names.size()), static_cast<std::uint32_t>(dir.size()), parent);
+        names += dir;
+        slots[slot] = id + 1;
+        if (dirs.size() * 2 > slots.size())
+            grow();
+        return id;
+    }
+
+    void grow() {
+        slots.assign(slots.size() * 2, 0);
+        auto mask = slots.size() - 1;
+        for (std::size_t id{1}; id < dirs.size(); id++) {
+            auto slot = slot_hash(dirs[id].parent, name(id)) & mask;
+            while (slots[slot] != 0)
+                slot = (slot + 1) & mask;
+            slots[slot] = id + 1;
+        }
+    }
+};
+
+// directory sizes sorted ascending with prefix sums, answers threshold queries in O(log n)
+struct size_index {
+    std::vector<std::size_t> sizes;
+    std::vector<std::size_t> prefix{0};        // prefix[i] is the sum of sizes[0, i)
+
+    explicit size_index(const file_sys& fileSys) {
+        sizes.reserve(fileSys.dirs.size());
+        for (std::size_t i{0}; i < fileSys.dirs.size(); i++)
+            sizes.push_back(fileSys.sum_size(i));
+        std::ranges::sort(sizes);
+
+        prefix.reserve(sizes.size() + 1);
+        for (auto size : sizes)
+            prefix.push_back(prefix.back() + size);
+    }
+
+    [[nodiscard]] std::size_t sum_at_most(std::size_t limit) const {
+        return prefix[static_cast<std::size_t>(std::ranges::upper_bound(sizes, limit) - sizes.begin())];
+    }
+
+    [[nodiscard]] std::optional<std::size_t> smallest_at_least(std::size_t needed) const {
+        auto it = std::ranges::lower_bound(sizes, needed);
+        if (it == sizes.end())
+            return std::nullopt;
+        return *it;
     }
 };
 
@@ -62,7 +135,7 @@ std::vector<std::string> get_input(const std::string& filename) {
     return result;
 }
 
-void handle_cd(file_sys& fileSys, const std::string& dir) {
+void handle_cd(file_sys& fileSys, std::string_view dir) {
     if (dir == "/")
         fileSys.go_root();
     else if (dir == "..")
@@ -71,11 +144,10 @@ void handle_cd(file_sys& fileSys, const std::string& dir) {
         fileSys.go_dir(dir);
 }
 
-void handle_filesize(file_sys& fileSys, const std::string& line) {
-    auto space = line.find(' ');
-    auto first = line.substr(0, space);
-    auto second = line.substr(space);
-    fileSys.add_file(file_node{second, std::stoull(first)});
+void handle_filesize(file_sys& fileSys, std::string_view line) {
+    std::size_t size{0};
+    std::from_chars(line.data(), line.data() + line.size(), size);
+    fileSys.add_file(size);
 }
 
 file_sys run_input(const std::vector<std::string>& input) {
@@ -83,35 +155,53 @@ file_sys run_input(const std::vector<std::string>& input) {
 
     for (std::size_t i{0}; i < input.size(); i++) {
         if (input[i].starts_with("$ cd "))
-            handle_cd(fileSys, input[i].substr(5));
+            handle_cd(fileSys, std::string_view{input[i]}.substr(5));
         else if (std::isdigit(input[i][0]))
             handle_filesize(fileSys, input[i]);
     }
+    fileSys.update_totals();
     return fileSys;
 }
 
-int main() {
+// usage: day7 [--at-most N...] [--at-least N...]
+void run_queries(const size_index& index, int argc, char* argv[]) {
+    std::string_view mode;
+    for (int i{1}; i < argc; i++) {
+        std::string_view arg{argv[i]};
+        if (arg.starts_with("--")) {
+            mode = arg;
+            continue;
+        }
+
+        auto value = std::stoull(argv[i]);
+        if (mode == "--at-most") {
+            std::cout << "at-most " << value << ": " << index.sum_at_most(value) << '\n';
+        } else if (mode == "--at-least") {
+            auto fit = index.smallest_at_least(value);
+            std::cout << "at-least " << value << ": ";
+            if (fit)
+                std::cout << *fit << '\n';
+            else
+                std::cout << "none\n";
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
     auto input = get_input("input.txt");
     auto sizes = run_input(input);
+    size_index index{sizes};
+    if (argc > 1) {
+        run_queries(index, argc, argv);
+        return 0;
+    }
 
     // part 1
-    std::vector<std::size_t> atMost100k;
-    for (const auto& path : sizes.path_map) {
-        auto size = sizes.sum_size(path.first);
-        if (size <= 100000)
-            atMost100k.push_back(size);
-    }
-    std::cout << std::accumulate(atMost100k.begin(), atMost100k.end(), 0ull) << '\n';
+    std::cout << index.sum_at_most(100000) << '\n';
 
     // part 2
-    auto freeSpace = 70000000 - sizes.sum_size("/");
+    auto freeSpace = 70000000 - sizes.sum_size(0);
     auto deleteSpace = 30000000 - freeSpace;
-    std::size_t minSizeDir{70000000};
-    for (const auto& path : sizes.path_map) {
-        auto size = sizes.sum_size(path.first);
-        if (size >= deleteSpace && size < minSizeDir)
-            minSizeDir = size;
-    }
-    std::cout << minSizeDir << '\n';
+    std::cout << index.smallest_at_least(deleteSpace).value_or(70000000) << '\n';
     return 0;
 }
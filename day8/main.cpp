@@ -1,6 +1,14 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
+#include <random>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
 #include <vector>
 
 struct trees {
@@ -14,128 +22,133 @@ struct trees {
         return heights.size();
     }
 
-    [[nodiscard]] bool can_see_up(std::size_t r, std::size_t c) const {
-        if (r == 0)
-            return true;
+    // fills row major visibility flags and scenic scores with one pass per direction, O(n) in the number of trees
+    void sweep(std::vector<std::uint8_t>& visible, std::vector<std::size_t>& scores) const {
+        visible.assign(width() * length(), 0);
+        scores.assign(width() * length(), 1);
+        std::vector<std::pair<std::size_t, char>> blockers;
+        blockers.reserve(std::max(width(), length()));
 
-        auto val = heights[r][c];
-        auto stop{false};
-        for (std::size_t i{r - 1}; !stop; i--) {
-            stop = i == 0;
-            if (val <= heights[i][c])
-                return false;
+        for (std::size_t r{0}; r < length(); r++) {
+            sweep_line(width(), [&](std::size_t k) { return std::make_pair(r, k); }, visible, scores, blockers);
+            sweep_line(width(), [&](std::size_t k) { return std::make_pair(r, width() - 1 - k); }, visible, scores, blockers);
         }
-        return true;
-    }
-
-    [[nodiscard]] bool can_see_down(std::size_t r, std::size_t c) const {
-        auto maxIdx = length() - 1;
-        if (r >= maxIdx)
-            return true;
-
-        auto val = heights[r][c];
-        for (std::size_t i{r + 1}; i <= maxIdx; i++) {
-            if (val <= heights[i][c])
-                return false;
-        }
-        return true;
-    }
-
-    [[nodiscard]] bool can_see_left(std::size_t r, std::size_t c) const {
-        if (c == 0)
-            return true;
-
-        auto val = heights[r][c];
-        auto stop{false};
-        for (std::size_t i{c - 1}; !stop; i--) {
-            stop = i == 0;
-            if (val <= heights[r][i])
-                return false;
+        for (std::size_t c{0}; c < width(); c++) {
+            sweep_line(length(), [&](std::size_t k) { return std::make_pair(k, c); }, visible, scores, blockers);
+            sweep_line(length(), [&](std::size_t k) { return std::make_pair(length() - 1 - k, c); }, visible, scores, blockers);
         }
-        return true;
     }
 
-    [[nodiscard]] bool can_see_right(std::size_t r, std::size_t c) const {
-        auto maxIdx = width() - 1;
-        if (c >= maxIdx)
-            return true;
-
-        auto val = heights[r][c];
-        for (std::size_t i{c + 1}; i <= maxIdx; i++) {
-            if (val <= heights[r][i])
-                return false;
+private:
+    // blockers is a monotonic stack of (position, height), the top is the nearest tree at least as tall
+    template <typename Cell>
+    void sweep_line(std::size_t count, Cell&& cell, std::vector<std::uint8_t>& visible, std::vector<std::size_t>& scores,
+                    std::vector<std::pair<std::size_t, char>>& blockers) const {
+        blockers.clear();
+        auto tallest{'0' - 1};
+        for (std::size_t k{0}; k < count; k++) {
+            auto [r, c] = cell(k);
+            auto val = heights[r][c];
+            auto idx = r * width() + c;
+            if (val > tallest) {
+                visible[idx] = 1;
+                tallest = val;
+            }
+
+            while (!blockers.empty() && blockers.back().second < val)
+                blockers.pop_back();
+            scores[idx] *= blockers.empty() ? k : k - blockers.back().first;
+            blockers.emplace_back(k, val);
         }
-        return true;
-    }
-
-    [[nodiscard]] bool can_see_any(std::size_t r, std::size_t c) const {
-        return can_see_left(r, c) || can_see_right(r, c) || can_see_up(r, c) || can_see_down(r, c);
-    }
-
-    [[nodiscard]] std::size_t up_dist(std::size_t r, std::size_t c) const {
-        if (r == 0)
-            return 0;
-
-        std::size_t dist{0};
-        auto val = heights[r][c];
-        auto stop{false};
-        for (std::size_t i{r - 1}; !stop; i--) {
-            stop = i == 0;
-            dist++;
-            if (val <= heights[i][c])
-                return dist;
-        }
-        return dist;
     }
+};
 
-    [[nodiscard]] std::size_t down_dist(std::size_t r, std::size_t c) const {
-        auto maxIdx = length() - 1;
-        if (r >= maxIdx)
-            return 0;
-
-        std::size_t dist{0};
-        auto val = heights[r][c];
-        for (std::size_t i{r + 1}; i <= maxIdx; i++) {
-            dist++;
-            if (val <= heights[i][c])
-                return dist;
+const std::size_t MergeTile = 64;
+
+// forward and backward sweep over one contiguous line, same as trees::sweep_line
+void sweep_span(const char* line, std::size_t count, std::uint8_t* visible, std::size_t* scores,
+                std::vector<std::pair<std::size_t, char>>& blockers) {
+    for (auto forward : {true, false}) {
+        blockers.clear();
+        auto tallest{'0' - 1};
+        for (std::size_t k{0}; k < count; k++) {
+            auto idx = forward ? k : count - 1 - k;
+            auto val = line[idx];
+            if (val > tallest) {
+                visible[idx] = 1;
+                tallest = val;
+            }
+
+            while (!blockers.empty() && blockers.back().second < val)
+                blockers.pop_back();
+            scores[idx] *= blockers.empty() ? k : k - blockers.back().first;
+            blockers.emplace_back(k, val);
         }
-        return dist;
     }
+}
 
-    [[nodiscard]] std::size_t left_dist(std::size_t r, std::size_t c) const {
-        if (c == 0)
-            return 0;
-
-        std::size_t dist{0};
-        auto val = heights[r][c];
-        auto stop{false};
-        for (std::size_t i{c - 1}; !stop; i--) {
-            stop = i == 0;
-            dist++;
-            if (val <= heights[r][i])
-                return dist;
-        }
-        return dist;
-    }
+// runs func(begin, end) over [0, count) split into one band per thread
+template <typename Func>
+void for_each_band(std::size_t count, std::size_t threads, Func&& func) {
+    threads = std::clamp<std::size_t>(threads, 1, std::max<std::size_t>(count, 1));
+    std::vector<std::jthread> workers;
+    workers.reserve(threads);
+    for (std::size_t t{0}; t < threads; t++)
+        workers.emplace_back([&func, begin = count * t / threads, end = count * (t + 1) / threads] { func(begin, end); });
+}
 
-    [[nodiscard]] std::size_t right_dist(std::size_t r, std::size_t c) const {
-        auto maxIdx = width() - 1;
-        if (c >= maxIdx)
-            return 0;
-
-        std::size_t dist{0};
-        auto val = heights[r][c];
-        for (std::size_t i{c + 1}; i <= maxIdx; i++) {
-            dist++;
-            if (val <= heights[r][i])
-                return dist;
+// heights in one row major buffer plus a column major copy, so every sweep reads contiguous memory
+struct flat_forest {
+    std::size_t width{0};
+    std::size_t length{0};
+    std::vector<char> rows;
+    std::vector<char> cols;
+    std::vector<std::uint8_t> col_visible;      // column major results of the column sweeps
+    std::vector<std::size_t> col_scores;
+
+    explicit flat_forest(const trees& forest) : width{forest.width()}, length{forest.length()} {
+        rows.reserve(width * length);
+        for (const auto& row : forest.heights)
+            rows.insert(rows.end(), row.begin(), row.end());
+
+        cols.resize(width * length);
+        for (std::size_t r{0}; r < length; r++) {
+            for (std::size_t c{0}; c < width; c++)
+                cols[c * length + r] = rows[r * width + c];
         }
-        return dist;
     }
 
-    [[nodiscard]] std::size_t score(std::size_t r, std::size_t c) const {
-        return up_dist(r, c) * down_dist(r, c) * left_dist(r, c) * right_dist(r, c);
+    // row bands and column bands are swept on separate threads, column results are merged back by row band
+    void sweep(std::vector<std::uint8_t>& visible, std::vector<std::size_t>& scores, std::size_t threads) {
+        visible.assign(width * length, 0);
+        scores.assign(width * length, 1);
+        col_visible.assign(width * length, 0);
+        col_scores.assign(width * length, 1);
+
+        for_each_band(length, threads, [&](std::size_t begin, std::size_t end) {
+            std::vector<std::pair<std::size_t, char>> blockers;
+            for (auto r = begin; r < end; r++)
+                sweep_span(rows.data() + r * width, width, visible.data() + r * width, scores.data() + r * width, blockers);
+        });
+        for_each_band(width, threads, [&](std::size_t begin, std::size_t end) {
+            std::vector<std::pair<std::size_t, char>> blockers;
+            for (auto c = begin; c < end; c++)
+                sweep_span(cols.data() + c * length, length, col_visible.data() + c * length, col_scores.data() + c * length, blockers);
+        });
+
+        // merge in square tiles so the column major reads stay in cache
+        for_each_band(length, threads, [&](std::size_t begin, std::size_t end) {
+            for (auto tileRow = begin; tileRow < end; tileRow += MergeTile) {
+                for (std::size_t tileCol{0}; tileCol < width; tileCol += MergeTile) {
+                    for (auto r = tileRow; r < std::min(tileRow + MergeTile, end); r++) {
+                        for (auto c = tileCol; c < std::min(tileCol + MergeTile, width); c++) {
+                            visible[r * width + c] |= col_visible[c * length + r];
+                            scores[r * width + c] *= col_scores[c * length + r];
+                        }
+                    }
+                }
+            }
+        });
     }
 };
 
@@ -149,28 +162,54 @@ trees get_input(const std::string& filename) {
     return trees{result};
 }
 
-int main() {
-    auto input = get_input("input.txt");
+template <typename Func>
+double time_ms(Func&& func) {
+    auto start = std::chrono::steady_clock::now();
+    func();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
 
-    // part 1
-    std::size_t count{0};
-    for (std::size_t r{0}; r < input.length(); r++) {
-        for (std::size_t c{0}; c < input.width(); c++) {
-            if (input.can_see_any(r, c))
-                count++;
-        }
+// usage: day8 --bench [size], compares the row string sweep with the flat forest on a random size x size forest
+void run_benchmark(std::size_t size) {
+    std::mt19937 rng{2022};
+    std::vector<std::string> heights(size, std::string(size, '0'));
+    for (auto& row : heights) {
+        for (auto& tree : row)
+            tree = static_cast<char>('0' + rng() % 10);
     }
-    std::cout << count << '\n';
+    trees forest{heights};
+    flat_forest flat{forest};
+
+    std::vector<std::uint8_t> expectedVisible;
+    std::vector<std::size_t> expectedScores;
+    auto baseMs = time_ms([&] { forest.sweep(expectedVisible, expectedScores); });
+    std::printf("%zux%zu forest, trees::sweep %.2f ms\n", size, size, baseMs);
+    std::cout << "threads   flat (ms)   speedup   result\n";
+
+    for (std::size_t threads : {1, 2, 4, 8, 16}) {
+        std::vector<std::uint8_t> visible;
+        std::vector<std::size_t> scores;
+        auto flatMs = time_ms([&] { flat.sweep(visible, scores, threads); });
+        auto match = visible == expectedVisible && scores == expectedScores;
+        std::printf("%7zu %11.2f %9.2f   %s\n", threads, flatMs, baseMs / flatMs, match ? "ok" : "MISMATCH");
+    }
+}
 
-    // part 2
-    std::size_t maxScore{0};
-    for (std::size_t r{0}; r < input.length(); r++) {
-        for (std::size_t c{0}; c < input.width(); c++) {
-            auto score = input.score(r, c);
-            if (score > maxScore)
-                maxScore = score;
-        }
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string_view{argv[1]} == "--bench") {
+        run_benchmark(argc > 2 ? std::stoul(argv[2]) : 4000);
+        return 0;
     }
-    std::cout << maxScore << '\n';
+
+    flat_forest input{get_input("input.txt")};
+    std::vector<std::uint8_t> visible;
+    std::vector<std::size_t> scores;
+    input.sweep(visible, scores, std::thread::hardware_concurrency());
+
+    // part 1
+    std::cout << std::ranges::count(visible, 1) << '\n';
+
+    // part 2
+    std::cout << std::ranges::max(scores) << '\n';
     return 0;
 }
@@ -1,11 +1,20 @@
 #include <algorithm>
+#include <bit>
+#include <cstdint>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
-#include <set>
+#include <iterator>
+#include <map>
 #include <string>
 #include <vector>
 
+const std::int64_t VisitedChunk = 64;           // bitmap bounds grow by at least this many cells per side
+const std::int64_t SparseFactor = 64;           // cells of the visited extent allowed per visited cell before going sparse
+const std::int64_t MinSparseArea = 1 << 22;     // boxes smaller than this always stay dense
+const std::int64_t RunIntervalMin = 64;         // sparse runs at least this long are stored as intervals
+const std::size_t InitialHashSlots = 1 << 10;
+
 struct instruction {
     char direction;
     int count;
@@ -23,17 +32,325 @@ struct coor {
     }
 };
 
-void tail_follow(char direction, const coor& head, coor& tail) {
-    if (std::abs(head.x - tail.x) > 1 || std::abs(head.y - tail.y) > 1) {
-        // tail out of range
-        switch (direction) {
-            case 'L': tail.x = head.x + 1; tail.y = head.y; break;
-            case 'R': tail.x = head.x - 1; tail.y = head.y; break;
-            case 'U': tail.y = head.y - 1; tail.x = head.x; break;
-            case 'D': tail.y = head.y + 1; tail.x = head.x; break;
-            default: break;
+// disjoint half open intervals, start -> end
+using interval_set = std::map<std::int64_t, std::int64_t>;
+
+[[nodiscard]] bool interval_contains(const interval_set& set, std::int64_t v) {
+    auto it = set.upper_bound(v);
+    return it != set.begin() && std::prev(it)->second > v;
+}
+
+// adds [lo, hi) to set, merging what it touches, and calls onGap for every part that was not in set yet
+template <typename Func>
+void interval_add(interval_set& set, std::int64_t lo, std::int64_t hi, Func&& onGap) {
+    auto it = set.upper_bound(lo);
+    if (it != set.begin() && std::prev(it)->second >= hi)
+        return;     // already covered, leave the map alone
+    if (it != set.begin() && std::prev(it)->second >= lo)
+        --it;
+
+    auto mergedLo = lo;
+    auto mergedHi = hi;
+    auto covered = lo;
+    while (it != set.end() && it->first <= hi) {
+        if (it->first > covered)
+            onGap(covered, it->first);
+        covered = std::max(covered, it->second);
+        mergedLo = std::min(mergedLo, it->first);
+        mergedHi = std::max(mergedHi, it->second);
+        it = set.erase(it);
+    }
+    if (covered < hi)
+        onGap(covered, hi);
+    set.emplace(mergedLo, mergedHi);
+}
+
+// distinct cells as a bitmap over a bounding box that grows in chunks, falling back to an open addressing
+// hash set of cells plus row and column intervals for long runs when the box would be mostly empty
+struct visited_cells {
+    std::int64_t min_x{0};
+    std::int64_t min_y{0};
+    std::int64_t width{0};          // min_x and width are multiples of 64, one row is width / 64 words
+    std::int64_t height{0};
+    std::vector<std::uint64_t> bits;
+
+    // tight extent of the visited cells, the bitmap box adds growth slack around it
+    std::int64_t lo_x{0};
+    std::int64_t lo_y{0};
+    std::int64_t hi_x{-1};
+    std::int64_t hi_y{-1};
+
+    // sparse cells are the union of the hash set and both maps, a cell may be in more than one of them
+    bool sparse{false};
+    std::vector<std::uint64_t> keys;
+    std::vector<std::uint8_t> used;
+    int hash_shift{64};
+    std::map<std::int64_t, interval_set> rows;      // y -> x intervals
+    std::map<std::int64_t, interval_set> cols;      // x -> y intervals
+    std::size_t run_cells{0};                       // distinct cells in the maps
+
+    std::size_t count{0};                           // set bits when dense, hashed cells when sparse
+
+    // O(hashed cells) when sparse, hashed cells that a run covers are only discounted here
+    [[nodiscard]] std::size_t size() const {
+        if (!sparse || run_cells == 0)
+            return count + run_cells;
+
+        auto result = run_cells;
+        for (std::size_t i{0}; i < keys.size(); i++) {
+            if (!used[i])
+                continue;
+
+            auto x = static_cast<std::int32_t>(keys[i] >> 32);
+            auto y = static_cast<std::int32_t>(keys[i]);
+            auto row = rows.find(y);
+            auto col = cols.find(x);
+            auto inRun = (row != rows.end() && interval_contains(row->second, x))
+                || (col != cols.end() && interval_contains(col->second, y));
+            result += !inRun;
+        }
+        return result;
+    }
+
+    void insert(const coor& c) {
+        if (!sparse && !in_bounds(c.x, c.y))
+            grow(c.x, c.y, 1);
+
+        if (sparse) {
+            hash_insert(c.x, c.y);
+            return;
+        }
+
+        extend(c.x, c.y);
+        set_bits(bit_idx(c.x, c.y), bit_idx(c.x, c.y) + 1);
+    }
+
+    // marks the cells start + step * 1..length, step being a unit move along one axis
+    void insert_run(const coor& start, const coor& step, std::int64_t length) {
+        if (length <= 0)
+            return;
+
+        auto endX = start.x + step.x * length;
+        auto endY = start.y + step.y * length;
+        if (!sparse && !in_bounds(endX, endY))
+            grow(endX, endY, length);
+        if (!sparse) {
+            extend(start.x + step.x, start.y + step.y);
+            extend(endX, endY);
+        }
+
+        auto firstX = std::min<std::int64_t>(start.x + step.x, endX);
+        auto firstY = std::min<std::int64_t>(start.y + step.y, endY);
+        if (sparse && length < RunIntervalMin) {
+            for (std::int64_t i{1}; i <= length; i++)
+                hash_insert(start.x + step.x * i, start.y + step.y * i);
+        } else if (sparse && step.y == 0) {
+            insert_row(start.y, firstX, firstX + length);
+        } else if (sparse) {
+            insert_col(start.x, firstY, firstY + length);
+        } else if (step.y == 0) {
+            auto first = bit_idx(firstX, start.y);
+            set_bits(first, first + static_cast<std::size_t>(length));
+        } else {
+            // one bit per row, bounded by the dense box height
+            for (std::int64_t i{1}; i <= length; i++)
+                set_bits(bit_idx(start.x, start.y + step.y * i), bit_idx(start.x, start.y + step.y * i) + 1);
+        }
+    }
+
+private:
+    [[nodiscard]] std::size_t bit_idx(std::int64_t x, std::int64_t y) const {
+        return static_cast<std::size_t>((y - min_y) * width + (x - min_x));
+    }
+
+    // sets bits [first, last) a word at a time, counting the ones that were clear
+    void set_bits(std::size_t first, std::size_t last) {
+        while (first < last) {
+            auto word = first / 64;
+            auto span = std::min<std::size_t>(64 - first % 64, last - first);
+            auto mask = (span == 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << span) - 1) << (first % 64);
+            count += static_cast<std::size_t>(std::popcount(mask & ~bits[word]));
+            bits[word] |= mask;
+            first += span;
         }
     }
+
+    [[nodiscard]] bool in_bounds(std::int64_t x, std::int64_t y) const {
+        return x >= min_x && x < min_x + width && y >= min_y && y < min_y + height;
+    }
+
+    void extend(std::int64_t x, std::int64_t y) {
+        if (hi_x < lo_x) {
+            lo_x = hi_x = x;
+            lo_y = hi_y = y;
+            return;
+        }
+        lo_x = std::min(lo_x, x);
+        hi_x = std::max(hi_x, x);
+        lo_y = std::min(lo_y, y);
+        hi_y = std::max(hi_y, y);
+    }
+
+    // doubles the box on each side that needs to grow, so growth is amortised O(1) per cell; when the doubled box
+    // is over budget it falls back to the visited extent plus a chunk per side, and goes sparse if even that is
+    void grow(std::int64_t x, std::int64_t y, std::int64_t pending) {
+        auto budget = std::max(MinSparseArea, SparseFactor * (static_cast<std::int64_t>(count) + pending));
+
+        auto newMinX = min_x;
+        auto newMinY = min_y;
+        auto newMaxX = min_x + width;
+        auto newMaxY = min_y + height;
+        if (x < newMinX)
+            newMinX = x - std::max(VisitedChunk, width);
+        if (x >= newMaxX)
+            newMaxX = x + 1 + std::max(VisitedChunk, width);
+        if (y < newMinY)
+            newMinY = y - std::max(VisitedChunk, height);
+        if (y >= newMaxY)
+            newMaxY = y + 1 + std::max(VisitedChunk, height);
+
+        newMinX &= ~std::int64_t{63};
+        auto newWidth = ((newMaxX + 63) & ~std::int64_t{63}) - newMinX;
+        auto newHeight = newMaxY - newMinY;
+        if (newWidth * newHeight > budget) {
+            auto empty = hi_x < lo_x;
+            newMinX = (empty ? x : std::min(lo_x, x)) - VisitedChunk;
+            newMinY = (empty ? y : std::min(lo_y, y)) - VisitedChunk;
+            newMaxX = (empty ? x : std::max(hi_x, x)) + 1 + VisitedChunk;
+            newMaxY = (empty ? y : std::max(hi_y, y)) + 1 + VisitedChunk;
+            newMinX &= ~std::int64_t{63};
+            newWidth = ((newMaxX + 63) & ~std::int64_t{63}) - newMinX;
+            newHeight = newMaxY - newMinY;
+            if (newWidth * newHeight > budget) {
+                to_sparse();
+                return;
+            }
+        }
+
+        auto area = newWidth * newHeight;
+        std::vector<std::uint64_t> newBits(static_cast<std::size_t>(area / 64));
+
+        // every visited cell lies in both boxes, and both are word aligned, so rows copy a word at a time
+        auto fromX = std::max(min_x, newMinX);
+        auto toX = std::min(min_x + width, newMinX + newWidth);
+        for (auto y = std::max(min_y, newMinY); y < std::min(min_y + height, newMinY + newHeight) && fromX < toX; y++) {
+            auto src = bits.begin() + static_cast<std::ptrdiff_t>(((y - min_y) * width + fromX - min_x) / 64);
+            auto dst = newBits.begin() + static_cast<std::ptrdiff_t>(((y - newMinY) * newWidth + fromX - newMinX) / 64);
+            std::copy(src, src + (toX - fromX) / 64, dst);
+        }
+
+        bits = std::move(newBits);
+        min_x = newMinX;
+        min_y = newMinY;
+        width = newWidth;
+        height = newHeight;
+    }
+
+    void to_sparse() {
+        sparse = true;
+        auto slots = std::bit_ceil(std::max(InitialHashSlots, count * 4));
+        keys.assign(slots, 0);
+        used.assign(slots, 0);
+        hash_shift = 64 - std::countr_zero(slots);
+
+        count = 0;
+        for (std::int64_t row{0}; row < height; row++) {
+            std::int64_t col{0};
+            while (col < width) {
+                auto idx = static_cast<std::size_t>(row * width + col);
+                if (!(bits[idx / 64] & (std::uint64_t{1} << (idx % 64)))) {
+                    col++;
+                    continue;
+                }
+
+                auto runEnd = col;
+                for (; runEnd < width; runEnd++) {
+                    auto runIdx = static_cast<std::size_t>(row * width + runEnd);
+                    if (!(bits[runIdx / 64] & (std::uint64_t{1} << (runIdx % 64))))
+                        break;
+                }
+
+                if (runEnd - col >= RunIntervalMin) {
+                    insert_row(row + min_y, col + min_x, runEnd + min_x);
+                } else {
+                    for (auto x = col; x < runEnd; x++)
+                        hash_insert(x + min_x, row + min_y);
+                }
+                col = runEnd;
+            }
+        }
+        bits.clear();
+        bits.shrink_to_fit();
+    }
+
+    static std::uint64_t pack(std::int64_t x, std::int64_t y) {
+        return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32) | static_cast<std::uint32_t>(y);
+    }
+
+    void hash_insert(std::int64_t x, std::int64_t y) {
+        auto key = pack(x, y);
+        auto mask = keys.size() - 1;
+        for (auto slot = (key * 0x9E3779B97F4A7C15ull) >> hash_shift;; slot = (slot + 1) & mask) {
+            if (!used[slot]) {
+                keys[slot] = key;
+                used[slot] = 1;
+                if (++count * 2 > keys.size())
+                    rehash();
+                return;
+            }
+            if (keys[slot] == key)
+                return;
+        }
+    }
+
+    void rehash() {
+        auto oldKeys = std::move(keys);
+        auto oldUsed = std::move(used);
+        keys.assign(oldKeys.size() * 2, 0);
+        used.assign(oldKeys.size() * 2, 0);
+        hash_shift--;
+
+        auto mask = keys.size() - 1;
+        for (std::size_t i{0}; i < oldKeys.size(); i++) {
+            if (!oldUsed[i])
+                continue;
+
+            auto slot = (oldKeys[i] * 0x9E3779B97F4A7C15ull) >> hash_shift;
+            while (used[slot])
+                slot = (slot + 1) & mask;
+            keys[slot] = oldKeys[i];
+            used[slot] = 1;
+        }
+    }
+
+    // cells of the new parts that a column already covers were counted before, one lookup per stored column in range
+    void insert_row(std::int64_t y, std::int64_t lo, std::int64_t hi) {
+        interval_add(rows[y], lo, hi, [&](std::int64_t gapLo, std::int64_t gapHi) {
+            run_cells += static_cast<std::size_t>(gapHi - gapLo);
+            for (auto it = cols.lower_bound(gapLo); it != cols.end() && it->first < gapHi; ++it)
+                run_cells -= interval_contains(it->second, y);
+        });
+    }
+
+    void insert_col(std::int64_t x, std::int64_t lo, std::int64_t hi) {
+        interval_add(cols[x], lo, hi, [&](std::int64_t gapLo, std::int64_t gapHi) {
+            run_cells += static_cast<std::size_t>(gapHi - gapLo);
+            for (auto it = rows.lower_bound(gapLo); it != rows.end() && it->first < gapHi; ++it)
+                run_cells -= interval_contains(it->second, x);
+        });
+    }
+};
+
+// moves knot one step towards leader on each axis when they no longer touch, returns whether it moved
+bool knot_follow(const coor& leader, coor& knot) {
+    auto dx = leader.x - knot.x;
+    auto dy = leader.y - knot.y;
+    if (std::abs(dx) <= 1 && std::abs(dy) <= 1)
+        return false;
+
+    knot.x += (dx > 0) - (dx < 0);
+    knot.y += (dy > 0) - (dy < 0);
+    return true;
 }
 
 void move_coor(char direction, coor& c) {
@@ -46,16 +363,50 @@ void move_coor(char direction, coor& c) {
     }
 }
 
-struct short_rope {
-    coor head{0, 0};
-    coor tail{0, 0};
-    std::set<coor> tail_visited{{0, 0}};
+struct rope {
+    std::vector<coor> knots;
+    std::size_t tracked;
+    visited_cells visited;
+
+    rope(std::size_t length, std::size_t tracked)
+        : knots(std::max<std::size_t>(length, 1), coor{0, 0}), tracked{std::min(tracked, knots.size() - 1)} {
+        visited.insert(knots[this->tracked]);
+    }
+
+    explicit rope(std::size_t length) : rope(length, length - 1) {}
 
     void move_head(const instruction& inst) {
+        coor step{0, 0};
+        move_coor(inst.direction, step);
+
         for (int i{0}; i < inst.count; i++) {
-            move_coor(inst.direction, head);
-            tail_follow(inst.direction, head, tail);
-            tail_visited.insert(tail);
+            move_coor(inst.direction, knots[0]);
+
+            // once a knot stays put every knot behind it does too
+            std::size_t moved{1};
+            auto translated{true};
+            for (; moved < knots.size(); moved++) {
+                auto before = knots[moved];
+                if (!knot_follow(knots[moved - 1], knots[moved]))
+                    break;
+                translated = translated && knots[moved].x - before.x == step.x && knots[moved].y - before.y == step.y;
+            }
+            if (moved > tracked)
+                visited.insert(knots[tracked]);
+
+            // every knot moved by the same step, so relative positions are fixed for the rest of the move
+            if (moved == knots.size() && translated) {
+                fast_forward(step, inst.count - i - 1);
+                return;
+            }
+        }
+    }
+
+    void fast_forward(const coor& step, int steps) {
+        visited.insert_run(knots[tracked], step, steps);
+        for (auto& knot : knots) {
+            knot.x += step.x * steps;
+            knot.y += step.y * steps;
         }
     }
 };
@@ -74,15 +425,22 @@ std::vector<instruction> get_input(const std::string& filename) {
     return result;
 }
 
-int main() {
+std::size_t count_visited(const std::vector<instruction>& input, std::size_t length) {
+    rope r{length};
+    std::ranges::for_each(input, [&r](auto&& i) { r.move_head(i); });
+    return r.visited.size();
+}
+
+int main(int argc, char* argv[]) {
     auto input = get_input("input.txt");
 
     // part 1
-    short_rope sr;
-    std::ranges::for_each(input, [&sr](auto&& i) { sr.move_head(i); });
-    std::cout << sr.tail_visited.size() << '\n';
+    std::cout << count_visited(input, 2) << '\n';
 
     // part 2
-    // TODO
+    std::cout << count_visited(input, 10) << '\n';
+
+    for (int i{1}; i < argc; i++)
+        std::cout << count_visited(input, std::stoul(argv[i])) << '\n';
     return 0;
 }